@@ -2,10 +2,31 @@
 
 #include "StreamingLevelSave.h"
 
+#include "StreamingLevelSaveStats.h"
+
 #define LOCTEXT_NAMESPACE "FStreamingLevelSaveModule"
 
 DEFINE_LOG_CATEGORY(LogStreamingLevelSave);
 
+DEFINE_STAT(STAT_StreamingLevelSave_CellDataCopies);
+DEFINE_STAT(STAT_StreamingLevelSave_RuntimeRecordCopies);
+DEFINE_STAT(STAT_StreamingLevelSave_WorkerDecodes);
+DEFINE_STAT(STAT_StreamingLevelSave_DecodeCell);
+DEFINE_STAT(STAT_StreamingLevelSave_MappedReads);
+DEFINE_STAT(STAT_StreamingLevelSave_MappedRead);
+DEFINE_STAT(STAT_StreamingLevelSave_BufferedRead);
+DEFINE_STAT(STAT_StreamingLevelSave_PersistentLevelCacheHits);
+DEFINE_STAT(STAT_StreamingLevelSave_WaitDecodeCell);
+DEFINE_STAT(STAT_StreamingLevelSave_IOQueueDepth);
+DEFINE_STAT(STAT_StreamingLevelSave_IOWaitUrgentRead);
+DEFINE_STAT(STAT_StreamingLevelSave_IOWaitPrefetchRead);
+DEFINE_STAT(STAT_StreamingLevelSave_IOWaitUnloadWrite);
+DEFINE_STAT(STAT_StreamingLevelSave_IOWaitSlotCopy);
+DEFINE_STAT(STAT_StreamingLevelSave_StoredObjects);
+DEFINE_STAT(STAT_StreamingLevelSave_UnchangedObjects);
+
+LLM_DEFINE_TAG(StreamingLevelSave);
+
 void FStreamingLevelSaveModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
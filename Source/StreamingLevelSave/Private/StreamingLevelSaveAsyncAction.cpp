@@ -0,0 +1,108 @@
+﻿#include "StreamingLevelSaveAsyncAction.h"
+
+#include "StreamingLevelSaveSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Kismet/GameplayStatics.h"
+
+UStreamingLevelSaveAsyncAction* UStreamingLevelSaveAsyncAction::AsyncSaveGame(UObject* WorldContextObject, FString SaveFileName,
+	bool bMultiplay, bool bLan)
+{
+	const auto Action = NewObject<UStreamingLevelSaveAsyncAction>();
+	if (const auto GameInstance = UGameplayStatics::GetGameInstance(WorldContextObject))
+	{
+		Action->RegisterWithGameInstance(GameInstance);
+		Action->Subsystem = GameInstance->GetSubsystem<UStreamingLevelSaveSubsystem>();
+	}
+	Action->SlotName = SaveFileName;
+	Action->bSave = true;
+	Action->bSessionMultiplay = bMultiplay;
+	Action->bSessionLan = bLan;
+	return Action;
+}
+
+UStreamingLevelSaveAsyncAction* UStreamingLevelSaveAsyncAction::AsyncLoadGame(UObject* WorldContextObject, FString SaveFileName,
+	bool bMultiplay, bool bLan)
+{
+	const auto Action = AsyncSaveGame(WorldContextObject, SaveFileName, bMultiplay, bLan);
+	Action->bSave = false;
+	return Action;
+}
+
+void UStreamingLevelSaveAsyncAction::Cancel()
+{
+	if (bRunning && Subsystem)
+	{
+		Subsystem->CancelSaveLoadSequence();
+	}
+}
+
+void UStreamingLevelSaveAsyncAction::Activate()
+{
+	// Another sequence owns the subsystem delegates now.
+	if (!Subsystem || Subsystem->IsSaving() || Subsystem->IsLoading())
+	{
+		Finish(false);
+		return;
+	}
+
+	bRunning = true;
+	Subsystem->OnSaveLoadFailed.AddDynamic(this, &ThisClass::OnSequenceFailed);
+	if (bSave)
+	{
+		Subsystem->OnSaveComplete.AddDynamic(this, &ThisClass::OnSequenceComplete);
+	}
+	else
+	{
+		Subsystem->OnLoadComplete.AddDynamic(this, &ThisClass::OnSequenceComplete);
+	}
+	Subsystem->BeginSaveLoadSequence(SlotName, bSave, bSessionMultiplay, bSessionLan);
+}
+
+void UStreamingLevelSaveAsyncAction::Tick(float DeltaTime)
+{
+	int32 CellsDone = 0;
+	int32 CellsTotal = 0;
+	int64 BytesDone = 0;
+	Subsystem->GetSaveLoadProgress(CellsDone, CellsTotal, BytesDone);
+	OnProgress.Broadcast(CellsDone, CellsTotal, BytesDone);
+}
+
+TStatId UStreamingLevelSaveAsyncAction::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStreamingLevelSaveAsyncAction, STATGROUP_Tickables);
+}
+
+void UStreamingLevelSaveAsyncAction::OnSequenceComplete()
+{
+	Finish(true);
+}
+
+void UStreamingLevelSaveAsyncAction::OnSequenceFailed()
+{
+	Finish(false);
+}
+
+void UStreamingLevelSaveAsyncAction::Finish(bool bSuccess)
+{
+	int32 CellsDone = 0;
+	int32 CellsTotal = 0;
+	int64 BytesDone = 0;
+	if (Subsystem)
+	{
+		Subsystem->GetSaveLoadProgress(CellsDone, CellsTotal, BytesDone);
+		Subsystem->OnSaveComplete.RemoveAll(this);
+		Subsystem->OnLoadComplete.RemoveAll(this);
+		Subsystem->OnSaveLoadFailed.RemoveAll(this);
+	}
+	bRunning = false;
+
+	if (bSuccess)
+	{
+		OnCompleted.Broadcast(CellsDone, CellsTotal, BytesDone);
+	}
+	else
+	{
+		OnFailed.Broadcast(CellsDone, CellsTotal, BytesDone);
+	}
+	SetReadyToDestroy();
+}
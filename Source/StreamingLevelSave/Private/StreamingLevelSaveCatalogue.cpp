@@ -0,0 +1,366 @@
+﻿#include "StreamingLevelSaveCatalogue.h"
+
+#include "StreamingLevelSave.h"
+#include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveSettings.h"
+#include "HAL/PlatformFileManager.h"
+
+// "SLSC"
+static constexpr uint32 CatalogueMagic = 0x43534C53;
+static constexpr int32 CatalogueVersion = 2;
+static constexpr int32 CatalogueVersionNestedFiles = 2;
+
+static FCriticalSection CatalogueLock;
+static TArray<FStreamingLevelSaveCatalogueEntry> CatalogueEntries;
+static bool bCatalogueLoaded = false;
+
+bool FStreamingLevelSaveCatalogue::UpdateSlot(const FString& SlotName, const TMap<FString, FString>* MetaData,
+	const TArray<uint8>* Thumbnail)
+{
+	if (SlotName.IsEmpty())
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CatalogueLock);
+	auto& Entries = GetEntries();
+	auto Entry = Entries.FindByPredicate([&SlotName](const FStreamingLevelSaveCatalogueEntry& Itr)
+	{
+		return Itr.SlotName == SlotName;
+	});
+	if (!Entry)
+	{
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->SlotName = SlotName;
+	}
+
+	ScanSlot(SlotName, *Entry);
+	Entry->Timestamp = FDateTime::UtcNow();
+	if (MetaData)
+	{
+		Entry->MetaData = *MetaData;
+	}
+	if (Thumbnail)
+	{
+		Entry->ThumbnailOffset = Thumbnail->Num() > 0 ? AppendThumbnail(*Thumbnail) : -1;
+		Entry->ThumbnailSize = Entry->ThumbnailOffset >= 0 ? Thumbnail->Num() : 0;
+		CompactThumbnails();
+	}
+
+	return SaveIndex();
+}
+
+void FStreamingLevelSaveCatalogue::RemoveSlot(const FString& SlotName)
+{
+	FScopeLock Lock(&CatalogueLock);
+	if (GetEntries().RemoveAll([&SlotName](const FStreamingLevelSaveCatalogueEntry& Itr) { return Itr.SlotName == SlotName; }) > 0)
+	{
+		CompactThumbnails();
+		SaveIndex();
+	}
+}
+
+void FStreamingLevelSaveCatalogue::RenameSlot(const FString& OldSlotName, const FString& NewSlotName)
+{
+	FScopeLock Lock(&CatalogueLock);
+	auto& Entries = GetEntries();
+	Entries.RemoveAll([&NewSlotName](const FStreamingLevelSaveCatalogueEntry& Itr) { return Itr.SlotName == NewSlotName; });
+	for (auto& Itr : Entries)
+	{
+		if (Itr.SlotName == OldSlotName)
+		{
+			Itr.SlotName = NewSlotName;
+		}
+	}
+	CompactThumbnails();
+	SaveIndex();
+}
+
+void FStreamingLevelSaveCatalogue::Refresh()
+{
+	FScopeLock Lock(&CatalogueLock);
+	auto& Entries = GetEntries();
+
+	TMap<FString, FDateTime> Folders;
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStat(*(FPaths::ProjectSavedDir() + "SaveGames/"),
+		[&Folders](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		const FString Name = FPaths::GetCleanFilename(Path);
+		if (StatData.bIsDirectory && IsSlotFolderName(Name))
+		{
+			Folders.Add(Name, StatData.ModificationTime);
+		}
+		return true;
+	});
+
+	bool bChanged = Entries.RemoveAll([&Folders](const FStreamingLevelSaveCatalogueEntry& Itr) { return !Folders.Contains(Itr.SlotName); }) > 0;
+	for (const auto& Pair : Folders)
+	{
+		auto Entry = Entries.FindByPredicate([&Pair](const FStreamingLevelSaveCatalogueEntry& Itr) { return Itr.SlotName == Pair.Key; });
+		if (!Entry)
+		{
+			Entry = &Entries.AddDefaulted_GetRef();
+			Entry->SlotName = Pair.Key;
+			Entry->Timestamp = Pair.Value;
+		}
+		else if (Entry->FolderTimestamp >= Pair.Value)
+		{
+			continue;
+		}
+
+		ScanSlot(Pair.Key, *Entry);
+		bChanged = true;
+	}
+
+	if (bChanged)
+	{
+		CompactThumbnails();
+		SaveIndex();
+	}
+}
+
+int32 FStreamingLevelSaveCatalogue::Query(int32 PageIndex, int32 PageSize, TArray<FStreamingLevelSaveCatalogueEntry>& OutEntries)
+{
+	OutEntries.Reset();
+
+	FScopeLock Lock(&CatalogueLock);
+	const auto& Entries = GetEntries();
+	TArray<int32> Order;
+	Order.Reserve(Entries.Num());
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		Order.Add(Index);
+	}
+	Order.Sort([&Entries](int32 A, int32 B) { return Entries[A].Timestamp > Entries[B].Timestamp; });
+
+	const int32 First = FMath::Max(PageIndex, 0) * FMath::Max(PageSize, 0);
+	const int32 Last = FMath::Min(First + FMath::Max(PageSize, 0), Order.Num());
+	for (int32 Index = First; Index < Last; ++Index)
+	{
+		OutEntries.Add(Entries[Order[Index]]);
+	}
+
+	return Entries.Num();
+}
+
+TArray<FStreamingLevelSaveCatalogueEntry> FStreamingLevelSaveCatalogue::GetAllEntries()
+{
+	FScopeLock Lock(&CatalogueLock);
+	return GetEntries();
+}
+
+bool FStreamingLevelSaveCatalogue::LoadThumbnail(const FStreamingLevelSaveCatalogueEntry& Entry, TArray<uint8>& OutPngData)
+{
+	OutPngData.Reset();
+	if (Entry.ThumbnailOffset < 0 || Entry.ThumbnailSize <= 0)
+	{
+		return false;
+	}
+
+	// Compaction moves thumbnails, read where catalogue has it now.
+	FScopeLock Lock(&CatalogueLock);
+	const auto Current = GetEntries().FindByPredicate([&Entry](const FStreamingLevelSaveCatalogueEntry& Itr)
+	{
+		return Itr.SlotName == Entry.SlotName;
+	});
+	if (!Current || Current->ThumbnailOffset < 0)
+	{
+		return false;
+	}
+
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*GetThumbnailsPath()));
+	if (!Reader || Current->ThumbnailOffset + Current->ThumbnailSize > Reader->TotalSize())
+	{
+		return false;
+	}
+
+	OutPngData.SetNumUninitialized(Current->ThumbnailSize);
+	Reader->Seek(Current->ThumbnailOffset);
+	Reader->Serialize(OutPngData.GetData(), OutPngData.Num());
+	return !Reader->IsError();
+}
+
+FString FStreamingLevelSaveCatalogue::GetIndexPath()
+{
+	return FPaths::ProjectSavedDir() + "SaveGames/_Catalogue.slc";
+}
+
+FString FStreamingLevelSaveCatalogue::GetThumbnailsPath()
+{
+	return FPaths::ProjectSavedDir() + "SaveGames/_Catalogue.slt";
+}
+
+TArray<FStreamingLevelSaveCatalogueEntry>& FStreamingLevelSaveCatalogue::GetEntries()
+{
+	if (bCatalogueLoaded)
+	{
+		return CatalogueEntries;
+	}
+	bCatalogueLoaded = true;
+
+	if (const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*GetIndexPath())); Reader)
+	{
+		uint32 Magic = 0;
+		int32 Version = 0;
+		int32 Num = 0;
+		*Reader << Magic << Version << Num;
+		if (Magic == CatalogueMagic && Version <= CatalogueVersion && Num >= 0)
+		{
+			CatalogueEntries.SetNum(Num);
+			for (auto& Itr : CatalogueEntries)
+			{
+				FStreamingLevelSaveCatalogueEntry::StaticStruct()->SerializeBin(*Reader, &Itr);
+				// Older entries are rescanned on next refresh.
+				if (Version >= CatalogueVersionNestedFiles)
+				{
+					*Reader << Itr.NestedFiles << Itr.FolderTimestamp;
+				}
+			}
+			if (!Reader->IsError())
+			{
+				return CatalogueEntries;
+			}
+		}
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Save catalogue is broken, rebuilding it."));
+		CatalogueEntries.Reset();
+	}
+
+	// First run with catalogue, list slots from save games folder once.
+	const FString SaveGamesDir = FPaths::ProjectSavedDir() + "SaveGames/";
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectory(*SaveGamesDir,
+		[](const TCHAR* Path, bool bIsDirectory)
+	{
+		const FString Name = FPaths::GetCleanFilename(Path);
+		if (bIsDirectory && IsSlotFolderName(Name))
+		{
+			auto& Entry = CatalogueEntries.AddDefaulted_GetRef();
+			Entry.SlotName = Name;
+			Entry.Timestamp = IFileManager::Get().GetTimeStamp(Path);
+			ScanSlot(Name, Entry);
+		}
+		return true;
+	});
+	SaveIndex();
+
+	return CatalogueEntries;
+}
+
+bool FStreamingLevelSaveCatalogue::SaveIndex()
+{
+	// Write aside and swap, a crash never leaves half an index.
+	const FString IndexPath = GetIndexPath();
+	const FString PartialPath = IndexPath + TEXT(".tmp");
+	{
+		const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*PartialPath));
+		if (!Writer)
+		{
+			return false;
+		}
+
+		uint32 Magic = CatalogueMagic;
+		int32 Version = CatalogueVersion;
+		int32 Num = CatalogueEntries.Num();
+		*Writer << Magic << Version << Num;
+		for (auto& Itr : CatalogueEntries)
+		{
+			FStreamingLevelSaveCatalogueEntry::StaticStruct()->SerializeBin(*Writer, &Itr);
+			*Writer << Itr.NestedFiles << Itr.FolderTimestamp;
+		}
+		if (!Writer->Close())
+		{
+			return false;
+		}
+	}
+
+	return IFileManager::Get().Move(*IndexPath, *PartialPath, true, true);
+}
+
+void FStreamingLevelSaveCatalogue::ScanSlot(const FString& SlotName, FStreamingLevelSaveCatalogueEntry& Entry)
+{
+	const FString SlotDir = UStreamingLevelSaveLibrary::MakeSaveGameDir(SlotName);
+	Entry.SizeBytes = 0;
+	Entry.RootFiles.Reset();
+	Entry.NestedFiles.Reset();
+	Entry.FolderTimestamp = IFileManager::Get().GetTimeStamp(*SlotDir);
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStatRecursively(*SlotDir,
+		[&Entry, &SlotDir](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		if (StatData.bIsDirectory)
+		{
+			return true;
+		}
+
+		Entry.SizeBytes += FMath::Max<int64>(StatData.FileSize, 0);
+		FString RelativePath = Path;
+		FPaths::MakePathRelativeTo(RelativePath, *SlotDir);
+		if (RelativePath.Contains(TEXT("/")))
+		{
+			Entry.NestedFiles.Add(MoveTemp(RelativePath));
+		}
+		else
+		{
+			Entry.RootFiles.Add(MoveTemp(RelativePath));
+		}
+		return true;
+	});
+}
+
+bool FStreamingLevelSaveCatalogue::IsSlotFolderName(const FString& Name)
+{
+	return !Name.StartsWith(TEXT("_")) && !Name.StartsWith(UStreamingLevelSaveSettings::GetTempFileFolder());
+}
+
+int64 FStreamingLevelSaveCatalogue::AppendThumbnail(const TArray<uint8>& PngData)
+{
+	const FString ThumbnailsPath = GetThumbnailsPath();
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*ThumbnailsPath, FILEWRITE_Append));
+	if (!Writer)
+	{
+		return -1;
+	}
+
+	const int64 Offset = Writer->Tell();
+	Writer->Serialize(const_cast<uint8*>(PngData.GetData()), PngData.Num());
+	return Writer->Close() ? Offset : -1;
+}
+
+void FStreamingLevelSaveCatalogue::CompactThumbnails()
+{
+	const FString ThumbnailsPath = GetThumbnailsPath();
+	const int64 FileSize = IFileManager::Get().FileSize(*ThumbnailsPath);
+	int64 LiveSize = 0;
+	for (const auto& Itr : CatalogueEntries)
+	{
+		LiveSize += Itr.ThumbnailOffset >= 0 ? Itr.ThumbnailSize : 0;
+	}
+
+	// Rewrite once replaced thumbnails take more space than live ones.
+	if (FileSize <= 0 || FileSize - LiveSize <= LiveSize)
+	{
+		return;
+	}
+
+	TArray<uint8> OldData;
+	if (!FFileHelper::LoadFileToArray(OldData, *ThumbnailsPath, FILEREAD_Silent))
+	{
+		return;
+	}
+
+	TArray<uint8> NewData;
+	NewData.Reserve(LiveSize);
+	for (auto& Itr : CatalogueEntries)
+	{
+		if (Itr.ThumbnailOffset < 0 || Itr.ThumbnailOffset + Itr.ThumbnailSize > OldData.Num())
+		{
+			Itr.ThumbnailOffset = -1;
+			Itr.ThumbnailSize = 0;
+			continue;
+		}
+
+		const int64 NewOffset = NewData.Num();
+		NewData.Append(OldData.GetData() + Itr.ThumbnailOffset, Itr.ThumbnailSize);
+		Itr.ThumbnailOffset = NewOffset;
+	}
+
+	FFileHelper::SaveArrayToFile(NewData, *ThumbnailsPath);
+}
@@ -0,0 +1,625 @@
+﻿#include "StreamingLevelSaveCellFile.h"
+
+#include "StreamingLevelSave.h"
+#include "StreamingLevelSaveFileWriter.h"
+#include "StreamingLevelSaveSettings.h"
+#include "StreamingLevelSaveStats.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+// Reject corrupted chunk headers before allocating.
+static constexpr int32 MaxCellFileChunkSize = 64 * 1024 * 1024;
+// Packed positions store 21 bits per axis.
+static constexpr uint64 PackedPositionMax = (1ull << 21) - 1;
+// Smallest three quaternion components lie within this.
+static constexpr double PackedRotationRange = UE_INV_SQRT_2;
+
+/** Buffers written bytes and writes them to inner archive one chunk at a time. */
+class FStreamingLevelSaveChunkWriter : public FArchive
+{
+public:
+	FStreamingLevelSaveChunkWriter(FArchive& InInner, FName InFormat, int32 InChunkSize)
+		: Inner(InInner)
+		, Format(InFormat)
+		, ChunkSize(InChunkSize)
+	{
+		SetIsSaving(true);
+		SetIsPersistent(true);
+		Chunk.Reserve(ChunkSize);
+	}
+
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		const uint8* Src = static_cast<const uint8*>(Data);
+		while (Num > 0)
+		{
+			const int64 Count = FMath::Min<int64>(Num, ChunkSize - Chunk.Num());
+			Chunk.Append(Src, Count);
+			Src += Count;
+			Num -= Count;
+			if (Chunk.Num() >= ChunkSize)
+			{
+				FlushChunk();
+			}
+		}
+	}
+
+	virtual FString GetArchiveName() const override { return TEXT("FStreamingLevelSaveChunkWriter"); }
+
+	/** Write remaining bytes and end marker. */
+	void Finish()
+	{
+		FlushChunk();
+		int32 End = 0;
+		Inner << End;
+		Inner << End;
+	}
+
+private:
+	void FlushChunk()
+	{
+		TArray<uint8>& Uncompressed = Chunk;
+		int32 UncompressedSize = Uncompressed.Num();
+		if (UncompressedSize == 0)
+		{
+			return;
+		}
+
+		// Store raw chunk if compression is disabled, fails or does not help.
+		int32 CompressedSize = 0;
+		if (!Format.IsNone())
+		{
+			TArray<uint8>& Compressed = CompressedChunk;
+			CompressedSize = FCompression::CompressMemoryBound(Format, UncompressedSize);
+			Compressed.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+			if (!FCompression::CompressMemory(Format, Compressed.GetData(), CompressedSize, Uncompressed.GetData(), UncompressedSize)
+				|| CompressedSize >= UncompressedSize)
+			{
+				CompressedSize = 0;
+			}
+		}
+
+		Inner << UncompressedSize;
+		if (CompressedSize > 0)
+		{
+			Inner << CompressedSize;
+			Inner.Serialize(CompressedChunk.GetData(), CompressedSize);
+		}
+		else
+		{
+			// Equal sizes mark a raw chunk.
+			Inner << UncompressedSize;
+			Inner.Serialize(Uncompressed.GetData(), UncompressedSize);
+		}
+
+		Uncompressed.Reset();
+	}
+
+	FArchive& Inner;
+	FName Format;
+	int32 ChunkSize;
+	TArray<uint8> Chunk;
+	TArray<uint8> CompressedChunk;
+};
+
+/**
+ * Reads chunks written by FStreamingLevelSaveChunkWriter one at a time.
+ * If file is mapped, raw chunks are read in place and compressed chunks are decompressed straight from the mapped view.
+ */
+class FStreamingLevelSaveChunkReader : public FArchive
+{
+public:
+	FStreamingLevelSaveChunkReader(FArchive& InInner, FName InFormat, TArrayView<const uint8> InMapped = TArrayView<const uint8>())
+		: Inner(InInner)
+		, Format(InFormat)
+		, Mapped(InMapped)
+	{
+		SetIsLoading(true);
+		SetIsPersistent(true);
+	}
+
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		uint8* Dest = static_cast<uint8*>(Data);
+		while (Num > 0)
+		{
+			if (Offset >= Current.Num() && !ReadChunk())
+			{
+				FMemory::Memzero(Dest, Num);
+				SetError();
+				return;
+			}
+
+			const int64 Count = FMath::Min<int64>(Num, Current.Num() - Offset);
+			FMemory::Memcpy(Dest, Current.GetData() + Offset, Count);
+			Offset += Count;
+			Dest += Count;
+			Num -= Count;
+		}
+	}
+
+	virtual FString GetArchiveName() const override { return TEXT("FStreamingLevelSaveChunkReader"); }
+
+private:
+	bool ReadChunk()
+	{
+		int32 UncompressedSize = 0;
+		int32 CompressedSize = 0;
+		Inner << UncompressedSize;
+		Inner << CompressedSize;
+		if (Inner.IsError() || UncompressedSize <= 0 || UncompressedSize > MaxCellFileChunkSize
+			|| CompressedSize <= 0 || CompressedSize > UncompressedSize)
+		{
+			return false;
+		}
+
+		Offset = 0;
+		const uint8* Source = nullptr;
+		if (Mapped.Num() > 0)
+		{
+			const int64 Pos = Inner.Tell();
+			if (Pos + CompressedSize > Mapped.Num())
+			{
+				return false;
+			}
+
+			Source = Mapped.GetData() + Pos;
+			Inner.Seek(Pos + CompressedSize);
+			if (CompressedSize == UncompressedSize)
+			{
+				Current = MakeArrayView(Source, UncompressedSize);
+				return true;
+			}
+		}
+
+		TArray<uint8>& Uncompressed = Chunk;
+		Uncompressed.SetNumUninitialized(UncompressedSize, EAllowShrinking::No);
+		Current = Uncompressed;
+		if (CompressedSize == UncompressedSize)
+		{
+			Inner.Serialize(Uncompressed.GetData(), UncompressedSize);
+			return !Inner.IsError();
+		}
+
+		if (!Source)
+		{
+			TArray<uint8>& Compressed = CompressedChunk;
+			Compressed.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+			Inner.Serialize(Compressed.GetData(), CompressedSize);
+			Source = Compressed.GetData();
+		}
+		return !Inner.IsError() && FCompression::UncompressMemory(Format, Uncompressed.GetData(), UncompressedSize, Source, CompressedSize);
+	}
+
+	FArchive& Inner;
+	FName Format;
+	TArrayView<const uint8> Mapped;
+	// Current chunk, either chunk buffer or mapped view.
+	TArrayView<const uint8> Current;
+	int32 Offset = 0;
+	TArray<uint8> Chunk;
+	TArray<uint8> CompressedChunk;
+};
+
+/** Reads object paths like its base, and records paths which did not resolve. */
+class FStreamingLevelSaveReaderProxy : public FObjectAndNameAsStringProxyArchive
+{
+public:
+	FStreamingLevelSaveReaderProxy(FArchive& InInner, bool bInLoadIfFindFails)
+		: FObjectAndNameAsStringProxyArchive(InInner, bInLoadIfFindFails)
+	{
+	}
+
+	using FObjectAndNameAsStringProxyArchive::operator<<;
+	virtual FArchive& operator<<(UObject*& Obj) override
+	{
+		FString LoadedString;
+		InnerArchive << LoadedString;
+		// Null objects are written as "None".
+		if (LoadedString.IsEmpty() || LoadedString == TEXT("None"))
+		{
+			Obj = nullptr;
+			return *this;
+		}
+
+		Obj = FindObject<UObject>(nullptr, *LoadedString, false);
+		if (!Obj && bLoadIfFindFails)
+		{
+			Obj = LoadObject<UObject>(nullptr, *LoadedString);
+		}
+		bUnresolved |= Obj == nullptr;
+		return *this;
+	}
+
+	bool bUnresolved = false;
+};
+
+bool FStreamingLevelSaveCellFile::Save(const FString& FilePath, FStreamingLevelSaveData& SaveData)
+{
+	LLM_SCOPE_BYTAG(StreamingLevelSave);
+	// Old file stays intact until new one is flushed.
+	const bool bAside = GetDefault<UStreamingLevelSaveSettings>()->Durability == EStreamingLevelSaveDurability::PerFile;
+	const FString WritePath = bAside ? FilePath + TEXT(".tmp") : FilePath;
+	const TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*WritePath));
+	if (!FileWriter)
+	{
+		return false;
+	}
+
+	const bool bSuccess = SaveToArchive(*FileWriter, SaveData);
+	if (!FileWriter->Close() || !bSuccess)
+	{
+		return false;
+	}
+
+	return !bAside || (FStreamingLevelSaveFileWriter::FlushFile(WritePath) && IFileManager::Get().Move(*FilePath, *WritePath, true, true));
+}
+
+bool FStreamingLevelSaveCellFile::SaveToMemory(TArray<uint8>& OutBytes, FStreamingLevelSaveData& SaveData)
+{
+	LLM_SCOPE_BYTAG(StreamingLevelSave);
+	FMemoryWriter MemoryWriter(OutBytes, true);
+	return SaveToArchive(MemoryWriter, SaveData);
+}
+
+bool FStreamingLevelSaveCellFile::SaveToArchive(FArchive& FileWriter, FStreamingLevelSaveData& SaveData)
+{
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	const int32 ChunkSize = FMath::Clamp(Settings->CellFileChunkSizeKB * 1024, 4 * 1024, MaxCellFileChunkSize);
+	FString FormatName = Settings->CellFileCompressionFormat.ToString();
+	uint32 FileMagic = Magic;
+	int32 Version = static_cast<int32>(EStreamingLevelSaveCellFileVersion::Latest);
+	FileWriter << FileMagic;
+	FileWriter << Version;
+	FileWriter << FormatName;
+
+	FStreamingLevelSaveChunkWriter ChunkWriter(FileWriter, Settings->CellFileCompressionFormat, ChunkSize);
+	FObjectAndNameAsStringProxyArchive WriterProxy(ChunkWriter, /*bInLoadIfFindFails*/false);
+	SerializeBody(WriterProxy, SaveData, Version);
+	ChunkWriter.Finish();
+	return !WriterProxy.IsError() && !FileWriter.IsError();
+}
+
+bool FStreamingLevelSaveCellFile::Load(const FString& FilePath, FStreamingLevelSaveData& SaveData)
+{
+	LLM_SCOPE_BYTAG(StreamingLevelSave);
+	SCOPE_CYCLE_COUNTER(STAT_StreamingLevelSave_DecodeCell);
+
+	// Map whole file if platform supports it, fall back to buffered file reader.
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	if (GetDefault<UStreamingLevelSaveSettings>()->bMemoryMapCellFiles)
+	{
+		MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+		if (MappedHandle && MappedHandle->GetFileSize() > 0)
+		{
+			MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+		}
+	}
+
+	if (MappedRegion)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_StreamingLevelSave_MappedRead);
+		INC_DWORD_STAT(STAT_StreamingLevelSave_MappedReads);
+		const TArrayView<const uint8> Mapped(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+		FMemoryReaderView MappedReader(Mapped, true);
+		return LoadFromArchive(MappedReader, FilePath, SaveData, Mapped);
+	}
+
+	const TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!FileReader)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_StreamingLevelSave_BufferedRead);
+	return LoadFromArchive(*FileReader, FilePath, SaveData, TArrayView<const uint8>());
+}
+
+bool FStreamingLevelSaveCellFile::LoadFromArchive(FArchive& FileReader, const FString& FilePath, FStreamingLevelSaveData& SaveData,
+	TArrayView<const uint8> Mapped)
+{
+	// Never load objects outside of game thread.
+	const bool bLoadIfFindFails = IsInGameThread();
+
+	// Legacy files start with destroyed actors count, never equal to magic.
+	uint32 FileMagic = 0;
+	int32 Version = static_cast<int32>(EStreamingLevelSaveCellFileVersion::Legacy);
+	if (FileReader.TotalSize() >= static_cast<int64>(sizeof(uint32)))
+	{
+		FileReader << FileMagic;
+	}
+
+	if (FileMagic == Magic)
+	{
+		FileReader << Version;
+	}
+	else
+	{
+		FileReader.Seek(0);
+	}
+
+	if (Version > static_cast<int32>(EStreamingLevelSaveCellFileVersion::Latest))
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Cell file %s has unknown version %d."), *FilePath, Version);
+		return false;
+	}
+
+	if (Version >= static_cast<int32>(EStreamingLevelSaveCellFileVersion::Chunked))
+	{
+		FString FormatName;
+		FileReader << FormatName;
+
+		FStreamingLevelSaveChunkReader ChunkReader(FileReader, FName(*FormatName), Mapped);
+		FStreamingLevelSaveReaderProxy ReaderProxy(ChunkReader, bLoadIfFindFails);
+		SerializeBody(ReaderProxy, SaveData, Version);
+		return !ReaderProxy.IsError() && !IsMissingTypes(ReaderProxy, FilePath);
+	}
+
+	// Legacy files are not chunked, read them straight from file archive.
+	FStreamingLevelSaveReaderProxy ReaderProxy(FileReader, bLoadIfFindFails);
+	SerializeBody(ReaderProxy, SaveData, Version);
+	return !ReaderProxy.IsError() && !IsMissingTypes(ReaderProxy, FilePath);
+}
+
+bool FStreamingLevelSaveCellFile::IsMissingTypes(const FStreamingLevelSaveReaderProxy& ReaderProxy, const FString& FilePath)
+{
+	// Records of types not loaded yet decode invalid, their actors would store defaults over saved state.
+	if (!ReaderProxy.bUnresolved || ReaderProxy.bLoadIfFindFails)
+	{
+		return false;
+	}
+
+	UE_LOG(LogStreamingLevelSave, Verbose, TEXT("Cell file %s references types which are not loaded, decode it on game thread."), *FilePath);
+	return true;
+}
+
+bool FStreamingLevelSaveCellFile::LoadFromMemory(TConstArrayView<uint8> Bytes, const FString& DebugName, FStreamingLevelSaveData& SaveData)
+{
+	LLM_SCOPE_BYTAG(StreamingLevelSave);
+	SCOPE_CYCLE_COUNTER(STAT_StreamingLevelSave_DecodeCell);
+	// Raw chunks are read in place, same as a mapped file.
+	FMemoryReaderView MemoryReader(Bytes, true);
+	return LoadFromArchive(MemoryReader, DebugName, SaveData, Bytes);
+}
+
+void FStreamingLevelSaveCellFile::SerializeBody(FArchive& Ar, FStreamingLevelSaveData& SaveData, int32 Version)
+{
+	// Legacy files have no dense datas or packed runtime actors.
+	const bool bHasPacked = Version >= static_cast<int32>(EStreamingLevelSaveCellFileVersion::Chunked);
+	FStreamingLevelSavePackedRuntimeData Packed;
+	TArray<FStreamingLevelSaveRuntimeData> PlainRecords;
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	const bool bPack = Ar.IsSaving() && bHasPacked && Settings->bPackRuntimeActors
+		&& PackRuntimeActors(SaveData.RuntimeActorsSaveDatas, Settings->PackedPositionPrecision, Packed);
+
+	// Plain records are moved aside while the rest is written, they and their payloads are moved back after.
+	if (bPack)
+	{
+		Swap(PlainRecords, SaveData.RuntimeActorsSaveDatas);
+	}
+
+	FStreamingLevelSaveData::StaticStruct()->SerializeBin(Ar, &SaveData);
+
+	if (bHasPacked)
+	{
+		FStreamingLevelSaveDenseData::StaticStruct()->SerializeBin(Ar, &SaveData.Dense);
+		FStreamingLevelSavePackedRuntimeData::StaticStruct()->SerializeBin(Ar, &Packed);
+	}
+	else if (Ar.IsLoading())
+	{
+		SaveData.Dense = FStreamingLevelSaveDenseData();
+	}
+
+	if (bPack)
+	{
+		Swap(PlainRecords, SaveData.RuntimeActorsSaveDatas);
+		ReturnPackedPayloads(Packed, SaveData.RuntimeActorsSaveDatas);
+	}
+	else if (Ar.IsLoading() && Packed.Num() > 0 && !Ar.IsError())
+	{
+		UnpackRuntimeActors(Packed, SaveData.RuntimeActorsSaveDatas);
+	}
+}
+
+static uint32 PackRotation(FQuat Quat)
+{
+	Quat.Normalize();
+	const double Components[4] = { Quat.X, Quat.Y, Quat.Z, Quat.W };
+	int32 Largest = 0;
+	for (int32 Index = 1; Index < 4; ++Index)
+	{
+		if (FMath::Abs(Components[Index]) > FMath::Abs(Components[Largest]))
+		{
+			Largest = Index;
+		}
+	}
+
+	// Q and -Q are the same rotation, flip so dropped component is positive.
+	const double Sign = Components[Largest] < 0.0 ? -1.0 : 1.0;
+	uint32 Packed = static_cast<uint32>(Largest) << 30;
+	int32 Shift = 20;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index != Largest)
+		{
+			const double Normalized = (Components[Index] * Sign / PackedRotationRange + 1.0) * 0.5;
+			Packed |= static_cast<uint32>(FMath::Clamp(FMath::RoundToInt(Normalized * 1023.0), 0, 1023)) << Shift;
+			Shift -= 10;
+		}
+	}
+	return Packed;
+}
+
+static FQuat UnpackRotation(uint32 Packed)
+{
+	const int32 Largest = static_cast<int32>(Packed >> 30);
+	double Components[4];
+	double SumSquares = 0.0;
+	int32 Shift = 20;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		if (Index != Largest)
+		{
+			Components[Index] = ((Packed >> Shift & 1023) / 1023.0 * 2.0 - 1.0) * PackedRotationRange;
+			SumSquares += FMath::Square(Components[Index]);
+			Shift -= 10;
+		}
+	}
+	Components[Largest] = FMath::Sqrt(FMath::Max(0.0, 1.0 - SumSquares));
+
+	FQuat Quat(Components[0], Components[1], Components[2], Components[3]);
+	Quat.Normalize();
+	return Quat;
+}
+
+bool FStreamingLevelSaveCellFile::PackRuntimeActors(TArray<FStreamingLevelSaveRuntimeData>& Records, float Precision,
+	FStreamingLevelSavePackedRuntimeData& OutPacked)
+{
+	if (Records.Num() == 0)
+	{
+		return false;
+	}
+
+	// Class table, class paths are written once per cell.
+	TMap<FSoftObjectPath, int32> ClassIndices;
+	OutPacked.ClassIndices.Reserve(Records.Num());
+	FBox Bounds(ForceInit);
+	for (const auto& Itr : Records)
+	{
+		const auto& ClassPath = Itr.ActorClass.ToSoftObjectPath();
+		int32 ClassIndex = 0;
+		if (const auto Found = ClassIndices.Find(ClassPath))
+		{
+			ClassIndex = *Found;
+		}
+		else
+		{
+			ClassIndex = OutPacked.Classes.Add(Itr.ActorClass);
+			ClassIndices.Add(ClassPath, ClassIndex);
+		}
+
+		if (ClassIndex > MAX_uint16)
+		{
+			OutPacked = FStreamingLevelSavePackedRuntimeData();
+			return false;
+		}
+		OutPacked.ClassIndices.Add(static_cast<uint16>(ClassIndex));
+		Bounds += Itr.ActorTransform.GetLocation();
+	}
+
+	// Records lie within their cell, quantize within their bounds. Step grows if bounds exceed 21 bits of steps.
+	const FVector Extent = Bounds.Max - Bounds.Min;
+	OutPacked.PositionOrigin = Bounds.Min;
+	OutPacked.PositionStep = FMath::Max(static_cast<double>(Precision), Extent.GetMax() / PackedPositionMax);
+	OutPacked.Positions.Reserve(Records.Num());
+	OutPacked.Rotations.Reserve(Records.Num());
+	OutPacked.AdditionalDatas.Reserve(Records.Num());
+	OutPacked.ComponentCounts.Reserve(Records.Num());
+	for (int32 Index = 0; Index < Records.Num(); ++Index)
+	{
+		auto& Record = Records[Index];
+		const FVector Steps = (Record.ActorTransform.GetLocation() - OutPacked.PositionOrigin) / OutPacked.PositionStep;
+		uint64 Position = 0;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const uint64 Quantized = static_cast<uint64>(FMath::Clamp<int64>(FMath::RoundToInt64(Steps[Axis]), 0, PackedPositionMax));
+			Position |= Quantized << (Axis * 21);
+		}
+		OutPacked.Positions.Add(Position);
+		OutPacked.Rotations.Add(PackRotation(Record.ActorTransform.GetRotation()));
+
+		if (const FVector Scale = Record.ActorTransform.GetScale3D(); !Scale.Equals(FVector::OneVector, UE_KINDA_SMALL_NUMBER))
+		{
+			OutPacked.ScaledIndices.Add(Index);
+			OutPacked.Scales.Add(FVector3f(Scale));
+		}
+		if (!Record.ActorVelocity.IsNearlyZero())
+		{
+			OutPacked.MovingIndices.Add(Index);
+			OutPacked.Velocities.Add(FVector3f(Record.ActorVelocity));
+		}
+
+		OutPacked.AdditionalDatas.Add(MoveTemp(Record.AdditionalData));
+		OutPacked.ComponentCounts.Add(Record.Components.Num());
+		for (auto& Pair : Record.Components)
+		{
+			OutPacked.ComponentGuids.Add(Pair.Key);
+			OutPacked.ComponentDatas.Add(MoveTemp(Pair.Value));
+		}
+	}
+	return true;
+}
+
+void FStreamingLevelSaveCellFile::ReturnPackedPayloads(FStreamingLevelSavePackedRuntimeData& Packed,
+	TArray<FStreamingLevelSaveRuntimeData>& Records)
+{
+	// Components are walked in the same order they were packed.
+	int32 ComponentIndex = 0;
+	for (int32 Index = 0; Index < Records.Num(); ++Index)
+	{
+		auto& Record = Records[Index];
+		Record.AdditionalData = MoveTemp(Packed.AdditionalDatas[Index]);
+		for (auto& Pair : Record.Components)
+		{
+			Pair.Value = MoveTemp(Packed.ComponentDatas[ComponentIndex++]);
+		}
+	}
+}
+
+void FStreamingLevelSaveCellFile::UnpackRuntimeActors(FStreamingLevelSavePackedRuntimeData& Packed,
+	TArray<FStreamingLevelSaveRuntimeData>& OutRecords)
+{
+	// Reject broken arrays instead of reading past them.
+	const int32 Num = Packed.Num();
+	if (Packed.Positions.Num() != Num || Packed.Rotations.Num() != Num || Packed.AdditionalDatas.Num() != Num
+		|| Packed.ComponentCounts.Num() != Num || Packed.ScaledIndices.Num() != Packed.Scales.Num()
+		|| Packed.MovingIndices.Num() != Packed.Velocities.Num() || Packed.ComponentGuids.Num() != Packed.ComponentDatas.Num())
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Packed runtime actors are inconsistent, dropping them."));
+		return;
+	}
+
+	const int32 First = OutRecords.Num();
+	OutRecords.Reserve(First + Num);
+	int32 ComponentIndex = 0;
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		auto& Record = OutRecords.AddDefaulted_GetRef();
+		if (Packed.Classes.IsValidIndex(Packed.ClassIndices[Index]))
+		{
+			Record.ActorClass = Packed.Classes[Packed.ClassIndices[Index]];
+		}
+
+		const uint64 Position = Packed.Positions[Index];
+		const FVector Steps(static_cast<double>(Position & PackedPositionMax), static_cast<double>(Position >> 21 & PackedPositionMax),
+			static_cast<double>(Position >> 42 & PackedPositionMax));
+		Record.ActorTransform = FTransform(UnpackRotation(Packed.Rotations[Index]), Packed.PositionOrigin + Steps * Packed.PositionStep);
+		Record.AdditionalData = MoveTemp(Packed.AdditionalDatas[Index]);
+
+		const int32 Count = FMath::Min(Packed.ComponentCounts[Index], Packed.ComponentGuids.Num() - ComponentIndex);
+		Record.Components.Reserve(Count);
+		for (int32 Offset = 0; Offset < Count; ++Offset, ++ComponentIndex)
+		{
+			Record.Components.Add(Packed.ComponentGuids[ComponentIndex], MoveTemp(Packed.ComponentDatas[ComponentIndex]));
+		}
+	}
+
+	for (int32 Index = 0; Index < Packed.ScaledIndices.Num(); ++Index)
+	{
+		if (Packed.ScaledIndices[Index] >= 0 && Packed.ScaledIndices[Index] < Num)
+		{
+			OutRecords[First + Packed.ScaledIndices[Index]].ActorTransform.SetScale3D(FVector(Packed.Scales[Index]));
+		}
+	}
+	for (int32 Index = 0; Index < Packed.MovingIndices.Num(); ++Index)
+	{
+		if (Packed.MovingIndices[Index] >= 0 && Packed.MovingIndices[Index] < Num)
+		{
+			OutRecords[First + Packed.MovingIndices[Index]].ActorVelocity = FVector(Packed.Velocities[Index]);
+		}
+	}
+}
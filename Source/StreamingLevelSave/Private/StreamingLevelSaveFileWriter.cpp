@@ -0,0 +1,144 @@
+﻿#include "StreamingLevelSaveFileWriter.h"
+
+#include "StreamingLevelSave.h"
+#include "HAL/PlatformFileManager.h"
+
+// Written last into a staging folder, only a complete staging folder is recovered.
+static const TCHAR* StagingCompleteFileName = TEXT("_Complete.slc");
+static const TCHAR* StagingSuffix = TEXT("_Staging");
+static const TCHAR* OldSuffix = TEXT("_Old");
+
+FStreamingLevelSaveFileWriter::FStreamingLevelSaveFileWriter(EStreamingLevelSaveDurability InDurability)
+	: Durability(InDurability)
+{
+}
+
+bool FStreamingLevelSaveFileWriter::Write(const FString& FilePath, TConstArrayView<uint8> Data)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const bool bAside = Durability == EStreamingLevelSaveDurability::PerFile;
+	const FString WritePath = bAside ? FilePath + TEXT(".tmp") : FilePath;
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(WritePath));
+	{
+		const TUniquePtr<IFileHandle> Handle(PlatformFile.OpenWrite(*WritePath));
+		if (!Handle || !Handle->Write(Data.GetData(), Data.Num()))
+		{
+			return false;
+		}
+
+		if (bAside && !Handle->Flush(true))
+		{
+			return false;
+		}
+	}
+
+	if (bAside)
+	{
+		return IFileManager::Get().Move(*FilePath, *WritePath, true, true);
+	}
+
+	if (Durability == EStreamingLevelSaveDurability::Staged)
+	{
+		UnflushedFiles.Add(FilePath);
+	}
+	return true;
+}
+
+bool FStreamingLevelSaveFileWriter::Copy(const FString& DestPath, const FString& SourcePath)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (Durability != EStreamingLevelSaveDurability::PerFile)
+	{
+		if (!PlatformFile.CopyFile(*DestPath, *SourcePath))
+		{
+			return false;
+		}
+
+		if (Durability == EStreamingLevelSaveDurability::Staged)
+		{
+			UnflushedFiles.Add(DestPath);
+		}
+		return true;
+	}
+
+	const FString WritePath = DestPath + TEXT(".tmp");
+	return PlatformFile.CopyFile(*WritePath, *SourcePath)
+		&& FlushFile(WritePath)
+		&& IFileManager::Get().Move(*DestPath, *WritePath, true, true);
+}
+
+bool FStreamingLevelSaveFileWriter::Commit()
+{
+	// After all writes, so writing is not stalled by flushes. Still one flush per file.
+	bool bSuccess = true;
+	for (const auto& Itr : UnflushedFiles)
+	{
+		bSuccess &= FlushFile(Itr);
+	}
+	UnflushedFiles.Reset();
+	return bSuccess;
+}
+
+bool FStreamingLevelSaveFileWriter::FlushFile(const FString& FilePath)
+{
+	const TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath, true));
+	return Handle && Handle->Flush(true);
+}
+
+FString FStreamingLevelSaveFileWriter::GetStagingFolder(const FString& Folder)
+{
+	return Folder + StagingSuffix;
+}
+
+bool FStreamingLevelSaveFileWriter::SwapInStagingFolder(const FString& Folder)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString StagingFolder = GetStagingFolder(Folder);
+	const FString OldFolder = Folder + OldSuffix;
+	const FString CompletePath = StagingFolder / StagingCompleteFileName;
+	{
+		const TUniquePtr<IFileHandle> Handle(PlatformFile.OpenWrite(*CompletePath));
+		if (!Handle || !Handle->Flush(true))
+		{
+			return false;
+		}
+	}
+
+	// Rename old folder away first, folder is either old, missing with staging complete, or new.
+	PlatformFile.DeleteDirectoryRecursively(*OldFolder);
+	if (PlatformFile.DirectoryExists(*Folder) && !PlatformFile.MoveFile(*OldFolder, *Folder))
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Failed to move %s aside."), *Folder);
+		return false;
+	}
+
+	if (!PlatformFile.MoveFile(*Folder, *StagingFolder))
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Failed to move %s into place."), *StagingFolder);
+		PlatformFile.MoveFile(*Folder, *OldFolder);
+		return false;
+	}
+
+	PlatformFile.DeleteDirectoryRecursively(*OldFolder);
+	PlatformFile.DeleteFile(*(Folder / StagingCompleteFileName));
+	return true;
+}
+
+void FStreamingLevelSaveFileWriter::RecoverFolder(const FString& Folder)
+{
+	// Marker in a staging folder is still needed to recover its folder.
+	if (Folder.EndsWith(StagingSuffix) || Folder.EndsWith(OldSuffix))
+	{
+		return;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString StagingFolder = GetStagingFolder(Folder);
+	if (!PlatformFile.DirectoryExists(*Folder) && PlatformFile.FileExists(*(StagingFolder / StagingCompleteFileName)))
+	{
+		UE_LOG(LogStreamingLevelSave, Log, TEXT("Finishing interrupted commit of %s."), *Folder);
+		PlatformFile.MoveFile(*Folder, *StagingFolder);
+	}
+	PlatformFile.DeleteFile(*(Folder / StagingCompleteFileName));
+	PlatformFile.DeleteDirectoryRecursively(*(Folder + OldSuffix));
+}
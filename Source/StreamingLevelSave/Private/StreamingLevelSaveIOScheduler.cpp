@@ -0,0 +1,189 @@
+﻿#include "StreamingLevelSaveIOScheduler.h"
+
+#include "StreamingLevelSaveStats.h"
+
+FStreamingLevelSaveIOScheduler::FStreamingLevelSaveIOScheduler(int32 InMaxConcurrentJobs)
+	: MaxConcurrentJobs(FMath::Max(InMaxConcurrentJobs, 1))
+{
+}
+
+UE::Tasks::FTask FStreamingLevelSaveIOScheduler::Enqueue(EStreamingLevelSaveIOPriority Priority, const FString& Key,
+	TUniqueFunction<void()>&& Work, double DistanceSquared, TConstArrayView<UE::Tasks::FTask> Prerequisites)
+{
+	const auto Job = MakeShared<FJob, ESPMode::ThreadSafe>();
+	Job->Key = Key;
+	Job->Work = MoveTemp(Work);
+	Job->Priority = Priority;
+	Job->DistanceSquared = DistanceSquared;
+	Job->EnqueueTime = FPlatformTime::Seconds();
+
+	const UE::Tasks::FTask Completion = UE::Tasks::Launch(UE_SOURCE_LOCATION, []() {}, UE::Tasks::Prerequisites(Job->Done));
+
+	TArray<UE::Tasks::FTask> AllPrerequisites(Prerequisites);
+	{
+		FScopeLock Lock(&Mutex);
+		Job->Sequence = NextSequence++;
+		if (!Key.IsEmpty())
+		{
+			// Run after previous job of the same key.
+			if (const auto Last = LastTaskByKey.Find(Key); Last && !Last->IsCompleted())
+			{
+				AllPrerequisites.Add(*Last);
+			}
+			LastTaskByKey.Add(Key, Completion);
+		}
+		QueuedJobs.Add(Job);
+		UpdateQueueStats();
+	}
+
+	if (AllPrerequisites.Num() == 0)
+	{
+		MarkReady(Job);
+	}
+	else
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared(), Job]()
+		{
+			Self->MarkReady(Job);
+		}, AllPrerequisites);
+	}
+
+	return Completion;
+}
+
+void FStreamingLevelSaveIOScheduler::Promote(const FString& Key, EStreamingLevelSaveIOPriority Priority)
+{
+	FScopeLock Lock(&Mutex);
+	for (const auto& Itr : QueuedJobs)
+	{
+		if (Itr->Key == Key && Itr->Priority > Priority)
+		{
+			Itr->Priority = Priority;
+		}
+	}
+	StartWorkers();
+}
+
+int32 FStreamingLevelSaveIOScheduler::GetQueueDepth() const
+{
+	FScopeLock Lock(&Mutex);
+	return QueuedJobs.Num();
+}
+
+void FStreamingLevelSaveIOScheduler::MarkReady(const TSharedRef<FJob, ESPMode::ThreadSafe>& Job)
+{
+	FScopeLock Lock(&Mutex);
+	Job->bReady = true;
+	StartWorkers();
+}
+
+void FStreamingLevelSaveIOScheduler::StartWorkers()
+{
+	int32 NumReady = 0;
+	bool bUrgentReady = false;
+	for (const auto& Itr : QueuedJobs)
+	{
+		NumReady += Itr->bReady ? 1 : 0;
+		bUrgentReady |= Itr->bReady && Itr->Priority == EStreamingLevelSaveIOPriority::UrgentRead;
+	}
+
+	// Game thread waits for urgent reads, run them in foreground even when every worker is busy.
+	if (bUrgentReady && RunningUrgentWorkers == 0)
+	{
+		++RunningUrgentWorkers;
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared()]()
+		{
+			Self->WorkerLoop(true);
+		}, UE::Tasks::ETaskPriority::High);
+	}
+
+	while (RunningWorkers < MaxConcurrentJobs && RunningWorkers < NumReady)
+	{
+		++RunningWorkers;
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Self = AsShared()]()
+		{
+			Self->WorkerLoop(false);
+		}, UE::Tasks::ETaskPriority::BackgroundNormal);
+	}
+}
+
+TSharedPtr<FStreamingLevelSaveIOScheduler::FJob, ESPMode::ThreadSafe> FStreamingLevelSaveIOScheduler::PopBestJob(bool bUrgentOnly)
+{
+	int32 BestIndex = INDEX_NONE;
+	for (int32 Index = 0; Index < QueuedJobs.Num(); ++Index)
+	{
+		const auto& Job = *QueuedJobs[Index];
+		if (!Job.bReady || (bUrgentOnly && Job.Priority != EStreamingLevelSaveIOPriority::UrgentRead))
+		{
+			continue;
+		}
+
+		if (BestIndex == INDEX_NONE)
+		{
+			BestIndex = Index;
+			continue;
+		}
+
+		// Priority class, then nearest cell, then oldest.
+		const auto& Best = *QueuedJobs[BestIndex];
+		if (Job.Priority != Best.Priority ? Job.Priority < Best.Priority
+			: Job.DistanceSquared != Best.DistanceSquared ? Job.DistanceSquared < Best.DistanceSquared
+			: Job.Sequence < Best.Sequence)
+		{
+			BestIndex = Index;
+		}
+	}
+
+	if (BestIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FJob, ESPMode::ThreadSafe> Result = QueuedJobs[BestIndex];
+	QueuedJobs.RemoveAtSwap(BestIndex, EAllowShrinking::No);
+	UpdateQueueStats();
+	return Result;
+}
+
+void FStreamingLevelSaveIOScheduler::WorkerLoop(bool bUrgent)
+{
+	for (;;)
+	{
+		TSharedPtr<FJob, ESPMode::ThreadSafe> Job;
+		{
+			FScopeLock Lock(&Mutex);
+			Job = PopBestJob(bUrgent);
+			if (!Job)
+			{
+				--(bUrgent ? RunningUrgentWorkers : RunningWorkers);
+				return;
+			}
+		}
+
+		const float WaitMs = static_cast<float>((FPlatformTime::Seconds() - Job->EnqueueTime) * 1000.0);
+		switch (Job->Priority)
+		{
+		case EStreamingLevelSaveIOPriority::UrgentRead:
+			SET_FLOAT_STAT(STAT_StreamingLevelSave_IOWaitUrgentRead, WaitMs);
+			break;
+		case EStreamingLevelSaveIOPriority::PrefetchRead:
+			SET_FLOAT_STAT(STAT_StreamingLevelSave_IOWaitPrefetchRead, WaitMs);
+			break;
+		case EStreamingLevelSaveIOPriority::UnloadWrite:
+			SET_FLOAT_STAT(STAT_StreamingLevelSave_IOWaitUnloadWrite, WaitMs);
+			break;
+		default:
+			SET_FLOAT_STAT(STAT_StreamingLevelSave_IOWaitSlotCopy, WaitMs);
+			break;
+		}
+
+		Job->Work();
+		Job->Work.Reset();
+		Job->Done.Trigger();
+	}
+}
+
+void FStreamingLevelSaveIOScheduler::UpdateQueueStats() const
+{
+	SET_DWORD_STAT(STAT_StreamingLevelSave_IOQueueDepth, QueuedJobs.Num());
+}
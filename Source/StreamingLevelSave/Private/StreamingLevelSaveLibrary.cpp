@@ -1,7 +1,14 @@
 ﻿#include "StreamingLevelSaveLibrary.h"
 
+#include "StreamingLevelSaveCatalogue.h"
 #include "StreamingLevelSaveInterface.h"
 #include "StreamingLevelSaveSettings.h"
+#include "StreamingLevelSaveSlot.h"
+#include "StreamingLevelSaveSubsystem.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Texture2D.h"
 
 FString UStreamingLevelSaveLibrary::GetTempFileFolder()
 {
@@ -103,6 +110,136 @@ ULevel* UStreamingLevelSaveLibrary::GetAssociateLevelDefault(const AActor* Actor
 	return Actor->GetWorld()->GetCurrentLevel();
 }
 
+static IImageWrapperModule* GetImageWrapperModule()
+{
+	// Only game thread may load modules, workers find it loaded.
+	return IsInGameThread()
+		? &FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper")
+		: FModuleManager::GetModulePtr<IImageWrapperModule>("ImageWrapper");
+}
+
+void UStreamingLevelSaveLibrary::DownscaleScreenshot(int32 Width, int32 Height, TConstArrayView<FColor> Colors, int32 MaxSize,
+	int32& OutWidth, int32& OutHeight, TArray<FColor>& OutColors)
+{
+	OutColors.Reset();
+	OutWidth = 0;
+	OutHeight = 0;
+	if (Width <= 0 || Height <= 0 || Colors.Num() != Width * Height)
+	{
+		return;
+	}
+
+	const int32 Factor = FMath::Max(FMath::DivideAndRoundUp(FMath::Max(Width, Height), FMath::Max(MaxSize, 1)), 1);
+	OutWidth = FMath::Max(Width / Factor, 1);
+	OutHeight = FMath::Max(Height / Factor, 1);
+	OutColors.SetNumUninitialized(OutWidth * OutHeight);
+
+	// Channels are summed in flat rows, inner loops stay branch free so they vectorize.
+	TArray<uint32> Sums;
+	Sums.SetNumUninitialized(OutWidth * 3);
+	const int32 BlockWidth = FMath::Min(Factor, Width);
+	const int32 BlockHeight = FMath::Min(Factor, Height);
+	const uint32 Divisor = BlockWidth * BlockHeight;
+	for (int32 OutY = 0; OutY < OutHeight; ++OutY)
+	{
+		FMemory::Memzero(Sums.GetData(), Sums.Num() * sizeof(uint32));
+		for (int32 Y = OutY * Factor; Y < OutY * Factor + BlockHeight; ++Y)
+		{
+			const FColor* Row = Colors.GetData() + Y * Width;
+			for (int32 OutX = 0; OutX < OutWidth; ++OutX)
+			{
+				const FColor* Block = Row + OutX * Factor;
+				uint32* Sum = Sums.GetData() + OutX * 3;
+				for (int32 X = 0; X < BlockWidth; ++X)
+				{
+					Sum[0] += Block[X].B;
+					Sum[1] += Block[X].G;
+					Sum[2] += Block[X].R;
+				}
+			}
+		}
+
+		FColor* OutRow = OutColors.GetData() + OutY * OutWidth;
+		for (int32 OutX = 0; OutX < OutWidth; ++OutX)
+		{
+			const uint32* Sum = Sums.GetData() + OutX * 3;
+			OutRow[OutX] = FColor(Sum[2] / Divisor, Sum[1] / Divisor, Sum[0] / Divisor, 255);
+		}
+	}
+}
+
+bool UStreamingLevelSaveLibrary::EncodeScreenshot(int32 Width, int32 Height, TConstArrayView<FColor> Colors, bool bJpeg,
+	int32 Quality, TArray<uint8>& OutData)
+{
+	OutData.Reset();
+	const auto Module = GetImageWrapperModule();
+	if (!Module || Width <= 0 || Height <= 0 || Colors.Num() != Width * Height)
+	{
+		return false;
+	}
+
+	const TSharedPtr<IImageWrapper> ImageWrapper = Module->CreateImageWrapper(bJpeg ? EImageFormat::JPEG : EImageFormat::PNG);
+	if (!ImageWrapper || !ImageWrapper->SetRaw(Colors.GetData(), Colors.Num() * sizeof(FColor), Width, Height, ERGBFormat::BGRA, 8))
+	{
+		return false;
+	}
+
+	const TArray64<uint8>& Compressed = ImageWrapper->GetCompressed(bJpeg ? Quality : 0);
+	OutData.Append(Compressed.GetData(), Compressed.Num());
+	return OutData.Num() > 0;
+}
+
+bool UStreamingLevelSaveLibrary::DecodeScreenshot(TConstArrayView<uint8> Data, int32& OutWidth, int32& OutHeight,
+	TArray<FColor>& OutColors)
+{
+	OutColors.Reset();
+	const auto Module = GetImageWrapperModule();
+	if (!Module || Data.Num() == 0)
+	{
+		return false;
+	}
+
+	const EImageFormat Format = Module->DetectImageFormat(Data.GetData(), Data.Num());
+	const TSharedPtr<IImageWrapper> ImageWrapper = Format != EImageFormat::Invalid ? Module->CreateImageWrapper(Format) : nullptr;
+	TArray64<uint8> Raw;
+	if (!ImageWrapper || !ImageWrapper->SetCompressed(Data.GetData(), Data.Num()) || !ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, Raw))
+	{
+		return false;
+	}
+
+	OutWidth = ImageWrapper->GetWidth();
+	OutHeight = ImageWrapper->GetHeight();
+	if (Raw.Num() != static_cast<int64>(OutWidth) * OutHeight * sizeof(FColor))
+	{
+		return false;
+	}
+
+	OutColors.SetNumUninitialized(OutWidth * OutHeight);
+	FMemory::Memcpy(OutColors.GetData(), Raw.GetData(), Raw.Num());
+	return true;
+}
+
+UTexture2D* UStreamingLevelSaveLibrary::CreateScreenshotTexture(int32 Width, int32 Height, const TArray<FColor>& Colors)
+{
+	check(IsInGameThread());
+	if (Width <= 0 || Height <= 0 || Colors.Num() != Width * Height)
+	{
+		return nullptr;
+	}
+
+	UTexture2D* Texture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+	if (!Texture)
+	{
+		return nullptr;
+	}
+
+	auto& Mip = Texture->GetPlatformData()->Mips[0];
+	FMemory::Memcpy(Mip.BulkData.Lock(LOCK_READ_WRITE), Colors.GetData(), Colors.Num() * sizeof(FColor));
+	Mip.BulkData.Unlock();
+	Texture->UpdateResource();
+	return Texture;
+}
+
 void UStreamingLevelSaveLibrary::InitGuidFromString(FString String, FGuid& Guid)
 {
 	Guid = FGuid::NewDeterministicGuid(String);
@@ -140,12 +277,24 @@ FGuid UStreamingLevelSaveLibrary::GetIdentityGuidInternal(const UObject* Object)
 
 FInstancedStruct UStreamingLevelSaveLibrary::GetSaveDataInternal(UObject* Object)
 {
+	// Reading state of deferred actor gives its saved state.
+	if (GetDefault<UStreamingLevelSaveSettings>()->bLazyRestorePersistentActors)
+	{
+		EnsureSaveDataRestored(Object);
+	}
+	
 	const auto SaveData = GetObjectDefaultSaveData(Object);
 	return FInstancedStruct::Make(SaveData);
 }
 
 void UStreamingLevelSaveLibrary::LoadSaveDataInternal(UObject* Object, const FInstancedStruct& SaveData)
 {
+	// Deferred state is older than given one, apply it first so it never overwrites given one later.
+	if (GetDefault<UStreamingLevelSaveSettings>()->bLazyRestorePersistentActors)
+	{
+		EnsureSaveDataRestored(Object);
+	}
+	
 	if (const auto DefaultSaveData = SaveData.GetPtr<FObjectDefaultSaveData>())
 	{
 		DefaultSaveData->LoadSaveData(Object);
@@ -154,6 +303,15 @@ void UStreamingLevelSaveLibrary::LoadSaveDataInternal(UObject* Object, const FIn
 	IStreamingLevelSaveInterface::Execute_PostLoadSaveData(Object);
 }
 
+bool UStreamingLevelSaveLibrary::EnsureSaveDataRestored(UObject* Object)
+{
+	const auto Component = Cast<UActorComponent>(Object);
+	const auto Actor = Component ? Component->GetOwner() : Cast<AActor>(Object);
+	const auto GameInstance = Actor ? Actor->GetGameInstance() : nullptr;
+	const auto Subsystem = GameInstance ? GameInstance->GetSubsystem<UStreamingLevelSaveSubsystem>() : nullptr;
+	return Subsystem && Subsystem->EnsureSaveDataRestored(Actor);
+}
+
 ULevel* UStreamingLevelSaveLibrary::GetAssociateLevelInternal(UObject* Object)
 {
 	if (const auto Actor = Cast<AActor>(Object))
@@ -195,7 +353,43 @@ bool UStreamingLevelSaveLibrary::DeleteSaveGame(const FString SaveGameName)
 		return false;
 	}
 
-	PlatformFile.DeleteDirectoryRecursively(*SaveFolder);
+	// Detaching copies cells into dependants, run after queued saves of slot instead of on game thread.
+	FStreamingLevelSaveSlot::EnqueueMaintenance(SaveGameName, [SaveGameName, SaveFolder]()
+	{
+		// Slots based on this one keep their cells.
+		FStreamingLevelSaveSlot::DetachDependants(SaveGameName);
+		FPlatformFileManager::Get().GetPlatformFile().DeleteDirectoryRecursively(*SaveFolder);
+		// Drop stored cells only this slot referenced.
+		FStreamingLevelSaveCatalogue::RemoveSlot(SaveGameName);
+		FStreamingLevelSaveSlot::CollectGarbage();
+	});
+	return true;
+}
+
+bool UStreamingLevelSaveLibrary::RenameSaveGame(const FString SaveGameName, const FString NewSaveGameName)
+{
+	if (SaveGameName.IsEmpty() || NewSaveGameName.IsEmpty() || SaveGameName == NewSaveGameName)
+	{
+		return false;
+	}
+	
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SaveFolder = MakeSaveGameFolder(SaveGameName);
+	const FString NewSaveFolder = MakeSaveGameFolder(NewSaveGameName);
+	if (!PlatformFile.DirectoryExists(*SaveFolder) || PlatformFile.DirectoryExists(*NewSaveFolder))
+	{
+		return false;
+	}
+
+	if (!PlatformFile.MoveFile(*NewSaveFolder, *SaveFolder))
+	{
+		return false;
+	}
+
+	// Slots based on this one refer to it by name.
+	FStreamingLevelSaveSlot::RenameSlot(SaveGameName, NewSaveGameName);
+
+	FStreamingLevelSaveCatalogue::RenameSlot(SaveGameName, NewSaveGameName);
 	return true;
 }
 
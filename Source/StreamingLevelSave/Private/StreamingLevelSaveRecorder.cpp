@@ -0,0 +1,123 @@
+﻿#include "StreamingLevelSaveRecorder.h"
+
+#include "StreamingLevelSave.h"
+#include "Misc/FileHelper.h"
+
+static const TCHAR* SessionHeader = TEXT("Time,Event,Name,Flags,DurationMs");
+// Bound memory of long sessions, lines are appended to file in batches.
+static constexpr int32 MaxPendingSessionLines = 256;
+
+void FStreamingLevelSaveRecorder::Start(const FString& InFilePath)
+{
+	Stop();
+	if (!FFileHelper::SaveStringToFile(FString(SessionHeader) + LINE_TERMINATOR, *InFilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Failed to start session recording %s."), *InFilePath);
+		return;
+	}
+
+	FilePath = InFilePath;
+	StartTime = FPlatformTime::Seconds();
+	UE_LOG(LogStreamingLevelSave, Log, TEXT("Recording session to %s."), *FilePath);
+}
+
+void FStreamingLevelSaveRecorder::Stop()
+{
+	Flush();
+	FilePath.Reset();
+}
+
+void FStreamingLevelSaveRecorder::Record(EStreamingLevelSaveRecordEvent Event, const FString& Name,
+	EStreamingLevelSaveRecordFlags Flags, double StartSeconds)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const double EventTime = StartSeconds > 0.0 ? StartSeconds : Now;
+	const double DurationMs = StartSeconds > 0.0 ? (Now - StartSeconds) * 1000.0 : 0.0;
+	PendingLines.Add(FString::Printf(TEXT("%.6f,%s,%s,%d,%.4f"), EventTime - StartTime, LexToString(Event),
+		*Name.Replace(TEXT(","), TEXT("_")), static_cast<int32>(Flags), DurationMs));
+
+	if (PendingLines.Num() >= MaxPendingSessionLines)
+	{
+		Flush();
+	}
+}
+
+void FStreamingLevelSaveRecorder::Flush()
+{
+	if (!IsRecording() || PendingLines.Num() == 0)
+	{
+		return;
+	}
+
+	FFileHelper::SaveStringArrayToFile(PendingLines, *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
+	PendingLines.Reset();
+}
+
+FString FStreamingLevelSaveRecorder::MakeSessionPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("StreamingLevelSave/Sessions") / FDateTime::Now().ToString() + TEXT(".csv");
+}
+
+bool FStreamingLevelSaveRecorder::LoadSession(const FString& InFilePath, TArray<FStreamingLevelSaveRecordedEvent>& OutEvents)
+{
+	OutEvents.Reset();
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *InFilePath) || Lines.Num() == 0 || Lines[0] != SessionHeader)
+	{
+		return false;
+	}
+
+	for (int32 Index = 1; Index < Lines.Num(); ++Index)
+	{
+		TArray<FString> Columns;
+		Lines[Index].ParseIntoArray(Columns, TEXT(","), false);
+		auto& Event = OutEvents.AddDefaulted_GetRef();
+		if (Columns.Num() != 5 || !LexTryParseString(Event.Event, *Columns[1]))
+		{
+			UE_LOG(LogStreamingLevelSave, Warning, TEXT("%s line %d is broken."), *InFilePath, Index + 1);
+			OutEvents.Pop();
+			continue;
+		}
+
+		LexFromString(Event.Time, *Columns[0]);
+		Event.Name = Columns[2];
+		int32 Flags = 0;
+		LexFromString(Flags, *Columns[3]);
+		Event.Flags = static_cast<EStreamingLevelSaveRecordFlags>(Flags);
+		LexFromString(Event.DurationMs, *Columns[4]);
+	}
+	return true;
+}
+
+const TCHAR* LexToString(EStreamingLevelSaveRecordEvent Event)
+{
+	switch (Event)
+	{
+	case EStreamingLevelSaveRecordEvent::LevelAdded: return TEXT("LevelAdded");
+	case EStreamingLevelSaveRecordEvent::LevelRemoved: return TEXT("LevelRemoved");
+	case EStreamingLevelSaveRecordEvent::BeginDecode: return TEXT("BeginDecode");
+	case EStreamingLevelSaveRecordEvent::SaveLevel: return TEXT("SaveLevel");
+	case EStreamingLevelSaveRecordEvent::LoadLevel: return TEXT("LoadLevel");
+	case EStreamingLevelSaveRecordEvent::BeginSequence: return TEXT("BeginSequence");
+	case EStreamingLevelSaveRecordEvent::EndSequence: return TEXT("EndSequence");
+	}
+	return TEXT("Unknown");
+}
+
+bool LexTryParseString(EStreamingLevelSaveRecordEvent& OutEvent, const TCHAR* String)
+{
+	for (uint8 Index = 0; Index <= static_cast<uint8>(EStreamingLevelSaveRecordEvent::EndSequence); ++Index)
+	{
+		if (FCString::Stricmp(String, LexToString(static_cast<EStreamingLevelSaveRecordEvent>(Index))) == 0)
+		{
+			OutEvent = static_cast<EStreamingLevelSaveRecordEvent>(Index);
+			return true;
+		}
+	}
+	return false;
+}
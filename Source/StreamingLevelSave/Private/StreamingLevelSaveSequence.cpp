@@ -3,7 +3,9 @@
 
 #include "StreamingLevelSaveSequence.h"
 
+#include "StreamingLevelSaveFileWriter.h"
 #include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveSlot.h"
 #include "StreamingLevelSaveSubsystem.h"
 
 UStreamingLevelSaveSubsystem* UStreamingLevelSaveSequence::GetSubsystem() const
@@ -28,25 +30,63 @@ void UStreamingLevelSaveSequence::SequenceFinish()
 }
 
 void UStreamingLevelSaveSequence::CopySaveFilesToTempPath() const
+{
+	CopySaveFilesToTempPath(SaveFileName, LevelsSaveFolder);
+}
+
+bool UStreamingLevelSaveSequence::CopySaveFilesToTempPath(const FString& InSaveFileName, const FString& InLevelsSaveFolder,
+	FStreamingLevelSaveProgress* Progress)
 {
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 
 	// Find folder
-	const FString SaveFolder = UStreamingLevelSaveLibrary::MakeSaveGameDir(SaveFileName) + LevelsSaveFolder;
+	const FString SaveFolder = UStreamingLevelSaveLibrary::MakeSaveGameDir(InSaveFileName) + InLevelsSaveFolder;
+	FStreamingLevelSaveFileWriter::RecoverFolder(SaveFolder);
 	if (!PlatformFile.DirectoryExists(*SaveFolder))
 	{
-		return;
+		return true;
 	}
 
-	// Copy temp files to save folder.
-	// TArray<FString> TempFiles;
-	// IFileManager::Get().FindFiles(TempFiles, *(SaveFolder + "/"));
 	// Create directory if not exist. Fixing loading problem.
-	if (!PlatformFile.DirectoryExists(*UStreamingLevelSaveLibrary::GetTempFileDir()))
+	const FString TempDir = UStreamingLevelSaveLibrary::GetTempFileDir();
+	if (!PlatformFile.DirectoryExists(*TempDir))
+	{
+		PlatformFile.CreateDirectory(*TempDir);
+	}
+
+	// Slots with a manifest may read cells from their base chain.
+	if (PlatformFile.FileExists(*(SaveFolder / FStreamingLevelSaveSlotManifest::FileName)))
 	{
-		PlatformFile.CreateDirectory(*UStreamingLevelSaveLibrary::GetTempFileDir());
+		return FStreamingLevelSaveSlot::ResolveToFolder(InSaveFileName, InLevelsSaveFolder, UStreamingLevelSaveLibrary::GetTempFileFolder(), Progress);
+	}
+
+	// Copy save files to temp folder.
+	TArray<FString> SaveFiles;
+	IFileManager::Get().FindFiles(SaveFiles, *(SaveFolder + "/"), true, false);
+	if (Progress)
+	{
+		Progress->CellsTotal = SaveFiles.Num();
+	}
+	
+	for (const auto& Itr : SaveFiles)
+	{
+		if (Progress && Progress->bCancelled)
+		{
+			return false;
+		}
+
+		const FString SourcePath = SaveFolder / Itr;
+		if (!PlatformFile.CopyFile(*(TempDir + Itr), *SourcePath))
+		{
+			return false;
+		}
+		if (Progress)
+		{
+			++Progress->CellsDone;
+			Progress->BytesDone += PlatformFile.FileSize(*SourcePath);
+		}
 	}
-	PlatformFile.CopyDirectoryTree(*UStreamingLevelSaveLibrary::GetTempFileDir(), *(SaveFolder + "/"), true);
+	return true;
 }
 
 class UWorld* UStreamingLevelSaveSequence::GetWorld() const
@@ -71,22 +111,6 @@ bool UStreamingLevelSaveSequence::IsAllowSaving_Implementation() const
 
 void UStreamingLevelSaveSequence::CopyTempFilesToSavePath() const
 {
-	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-
-	// Create folder
-	const FString SaveFolder = UStreamingLevelSaveLibrary::MakeSaveGameDir(SaveFileName) + LevelsSaveFolder;
-	if (!PlatformFile.DirectoryExists(*SaveFolder))
-	{
-		if (!PlatformFile.CreateDirectoryTree(*SaveFolder))
-		{
-			return;
-		}
-	}
-
-	// Copy temp files to save folder.
-	const auto TempFiles = GetSubsystem()->CollectTempSaveFiles();
-	for (const auto FileName : TempFiles)
-	{
-		PlatformFile.CopyFile(*(SaveFolder + "/" + FileName), *(UStreamingLevelSaveLibrary::GetTempFileDir() + FileName));
-	}
+	// Copied from a snapshot on a worker, finished before sequence ends.
+	GetSubsystem()->BeginSaveSnapshot(SaveFileName, LevelsSaveFolder);
 }
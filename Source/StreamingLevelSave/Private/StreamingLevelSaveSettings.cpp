@@ -33,8 +33,16 @@ TSubclassOf<UStreamingLevelSaveSequence> UStreamingLevelSaveSettings::GetDefault
 	return nullptr;
 }
 
+// Set before subsystem starts, workers only read it.
+static FString TempFileFolderOverride;
+
 FString UStreamingLevelSaveSettings::GetTempFileFolder()
 {
+	if (!TempFileFolderOverride.IsEmpty())
+	{
+		return TempFileFolderOverride;
+	}
+
 	if (const auto Settings = GetDefault<UStreamingLevelSaveSettings>())
 	{
 		return Settings->TempSaveFilesFolder;
@@ -42,3 +50,8 @@ FString UStreamingLevelSaveSettings::GetTempFileFolder()
 	
 	return "TempLevels";
 }
+
+void UStreamingLevelSaveSettings::SetTempFileFolderOverride(const FString& Folder)
+{
+	TempFileFolderOverride = Folder;
+}
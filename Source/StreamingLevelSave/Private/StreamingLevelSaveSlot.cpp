@@ -0,0 +1,491 @@
+﻿#include "StreamingLevelSaveSlot.h"
+
+#include "StreamingLevelSave.h"
+#include "StreamingLevelSaveCatalogue.h"
+#include "StreamingLevelSaveFileWriter.h"
+#include "StreamingLevelSaveIOScheduler.h"
+#include "StreamingLevelSaveLibrary.h"
+#include "Hash/CityHash.h"
+#include "HAL/PlatformFileManager.h"
+#include "Serialization/MemoryWriter.h"
+
+const TCHAR* FStreamingLevelSaveSlotManifest::FileName = TEXT("_Manifest.slm");
+
+// "SLSM"
+static constexpr uint32 SlotManifestMagic = 0x4D534C53;
+static constexpr int32 SlotManifestVersion = 1;
+// Bound chain walks, a broken manifest must not loop forever.
+static constexpr int32 MaxSlotChainWalk = 64;
+
+static FCriticalSection MaintenanceSchedulerLock;
+static TWeakPtr<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe> MaintenanceScheduler;
+
+FString FStreamingLevelSaveSlotManifest::GetLevelsFolder() const
+{
+	return FStreamingLevelSaveSlot::MakeLevelsFolder(SlotName, LevelsFolderName);
+}
+
+bool FStreamingLevelSaveSlotManifest::Load(const FString& LevelsFolder)
+{
+	// Every slot read starts here, finish a swap a crash interrupted first. Swaps hold manifest lock.
+	{
+		FScopeLock Lock(&FStreamingLevelSaveSlot::GetManifestLock());
+		FStreamingLevelSaveFileWriter::RecoverFolder(LevelsFolder);
+	}
+
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*(LevelsFolder / FileName)));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	Serialize(*Reader);
+	return !Reader->IsError();
+}
+
+bool FStreamingLevelSaveSlotManifest::Save(const FString& LevelsFolder) const
+{
+	FStreamingLevelSaveFileWriter Writer(GetDefault<UStreamingLevelSaveSettings>()->Durability == EStreamingLevelSaveDurability::None
+		? EStreamingLevelSaveDurability::None
+		: EStreamingLevelSaveDurability::PerFile);
+	return Save(LevelsFolder, Writer);
+}
+
+bool FStreamingLevelSaveSlotManifest::Save(const FString& LevelsFolder, FStreamingLevelSaveFileWriter& Writer) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter MemoryWriter(Bytes);
+	const_cast<FStreamingLevelSaveSlotManifest*>(this)->Serialize(MemoryWriter);
+	return Writer.Write(LevelsFolder / FileName, Bytes);
+}
+
+void FStreamingLevelSaveSlotManifest::Serialize(FArchive& Ar)
+{
+	uint32 Magic = SlotManifestMagic;
+	int32 Version = SlotManifestVersion;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != SlotManifestMagic || Version > SlotManifestVersion)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << SlotName;
+	Ar << LevelsFolderName;
+	Ar << BaseSlot;
+	Ar << ChainLength;
+	Ar << CellHashes;
+	Ar << StoredCells;
+	Ar << bContentAddressed;
+	Ar << Dependants;
+	Ar << CellDigests;
+}
+
+static FStreamingLevelSaveCellDigest MakeCellDigest(TConstArrayView<uint8> Bytes)
+{
+	FStreamingLevelSaveCellDigest Digest;
+	Digest.Size = Bytes.Num();
+	FSHA1::HashBuffer(Bytes.GetData(), Bytes.Num(), Digest.Sha.Hash);
+	return Digest;
+}
+
+FString FStreamingLevelSaveSlot::MakeLevelsFolder(const FString& SaveGameName, const FString& LevelsFolderName)
+{
+	return UStreamingLevelSaveLibrary::MakeSaveGameDir(SaveGameName) + LevelsFolderName;
+}
+
+uint64 FStreamingLevelSaveSlot::HashFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath, FILEREAD_Silent))
+	{
+		return 0;
+	}
+
+	return CityHash64(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+}
+
+bool FStreamingLevelSaveSlot::DigestFile(const FString& FilePath, uint64& OutHash, FStreamingLevelSaveCellDigest& OutDigest)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	DigestBytes(Bytes, OutHash, OutDigest);
+	return true;
+}
+
+void FStreamingLevelSaveSlot::DigestBytes(TConstArrayView<uint8> Bytes, uint64& OutHash, FStreamingLevelSaveCellDigest& OutDigest)
+{
+	OutHash = CityHash64(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+	OutDigest = MakeCellDigest(Bytes);
+}
+
+bool FStreamingLevelSaveSlot::LoadVerifiedCell(const FStreamingLevelSaveSlotManifest& Manifest, const FString& CellFileName,
+	const FString& FilePath, TArray<uint8>& OutBytes)
+{
+	if (!FFileHelper::LoadFileToArray(OutBytes, *FilePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	const auto Expected = Manifest.CellDigests.Find(CellFileName);
+	if (!Expected || *Expected != MakeCellDigest(OutBytes))
+	{
+		UE_LOG(LogStreamingLevelSave, Warning, TEXT("Slot %s cell %s does not match its digest, %s is corrupt or another cell."),
+			*Manifest.SlotName, *CellFileName, *FilePath);
+		return false;
+	}
+	return true;
+}
+
+bool FStreamingLevelSaveSlot::ResolveToFolder(const FString& SaveGameName, const FString& LevelsFolderName, const FString& DestFolder,
+	FStreamingLevelSaveProgress* Progress)
+{
+	FStreamingLevelSaveSlotManifest Manifest;
+	if (!Manifest.Load(MakeLevelsFolder(SaveGameName, LevelsFolderName)))
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*DestFolder);
+
+	if (Progress)
+	{
+		Progress->CellsTotal = Manifest.CellHashes.Num();
+	}
+
+	bool bSuccess = true;
+	for (const auto& Pair : Manifest.CellHashes)
+	{
+		if (Progress && Progress->bCancelled)
+		{
+			return false;
+		}
+
+		const FString SourcePath = FindStoredCell(Manifest, Pair.Key);
+		TArray<uint8> Bytes;
+		if (SourcePath.IsEmpty() || !LoadVerifiedCell(Manifest, Pair.Key, SourcePath, Bytes)
+			|| !FFileHelper::SaveArrayToFile(Bytes, *(DestFolder / Pair.Key)))
+		{
+			UE_LOG(LogStreamingLevelSave, Warning, TEXT("Slot %s could not resolve cell %s."), *SaveGameName, *Pair.Key);
+			bSuccess = false;
+		}
+		else if (Progress)
+		{
+			++Progress->CellsDone;
+			Progress->BytesDone += Bytes.Num();
+		}
+	}
+
+	return bSuccess;
+}
+
+bool FStreamingLevelSaveSlot::Compact(const FString& SaveGameName, const FString& LevelsFolderName)
+{
+	const FString LevelsFolder = MakeLevelsFolder(SaveGameName, LevelsFolderName);
+	FStreamingLevelSaveSlotManifest Manifest;
+	if (!Manifest.Load(LevelsFolder))
+	{
+		return false;
+	}
+
+	if (!Manifest.IsDifferential())
+	{
+		return true;
+	}
+
+	for (const auto& Pair : Manifest.CellHashes)
+	{
+		if (Manifest.StoredCells.Contains(Pair.Key))
+		{
+			continue;
+		}
+
+		const FString SourcePath = FindStoredCell(Manifest, Pair.Key);
+		TArray<uint8> Bytes;
+		if (SourcePath.IsEmpty() || !LoadVerifiedCell(Manifest, Pair.Key, SourcePath, Bytes)
+			|| !FFileHelper::SaveArrayToFile(Bytes, *(LevelsFolder / Pair.Key)))
+		{
+			// Keep depending on base, nothing is lost.
+			UE_LOG(LogStreamingLevelSave, Warning, TEXT("Slot %s could not compact cell %s."), *SaveGameName, *Pair.Key);
+			return false;
+		}
+		Manifest.StoredCells.Add(Pair.Key);
+	}
+
+	// Slots may have been based on this one while copying.
+	FScopeLock Lock(&GetManifestLock());
+	FStreamingLevelSaveSlotManifest Latest;
+	if (!Latest.Load(LevelsFolder))
+	{
+		return false;
+	}
+
+	const FString OldBaseSlot = Manifest.BaseSlot;
+	Manifest.Dependants = MoveTemp(Latest.Dependants);
+	Manifest.BaseSlot.Empty();
+	Manifest.ChainLength = 0;
+	if (!Manifest.Save(LevelsFolder))
+	{
+		return false;
+	}
+
+	UpdateDependantIndex(OldBaseSlot, LevelsFolderName, SaveGameName, FString());
+	return true;
+}
+
+void FStreamingLevelSaveSlot::DetachDependants(const FString& SaveGameName)
+{
+	for (auto& Manifest : LoadSlotManifests(SaveGameName))
+	{
+		for (const auto& Dependant : Manifest.Dependants)
+		{
+			FStreamingLevelSaveSlotManifest DependantManifest;
+			if (DependantManifest.Load(MakeLevelsFolder(Dependant, Manifest.LevelsFolderName))
+				&& DependantManifest.BaseSlot == SaveGameName)
+			{
+				Compact(Dependant, Manifest.LevelsFolderName);
+			}
+		}
+	}
+}
+
+void FStreamingLevelSaveSlot::UpdateDependantIndex(const FString& BaseSlot, const FString& LevelsFolderName,
+	const FString& Removed, const FString& Added)
+{
+	if (BaseSlot.IsEmpty())
+	{
+		return;
+	}
+
+	FScopeLock Lock(&GetManifestLock());
+	const FString LevelsFolder = MakeLevelsFolder(BaseSlot, LevelsFolderName);
+	FStreamingLevelSaveSlotManifest Manifest;
+	if (!Manifest.Load(LevelsFolder))
+	{
+		return;
+	}
+
+	Manifest.Dependants.Remove(Removed);
+	if (!Added.IsEmpty())
+	{
+		Manifest.Dependants.Add(Added);
+	}
+	Manifest.Save(LevelsFolder);
+}
+
+void FStreamingLevelSaveSlot::RenameSlot(const FString& OldSaveGameName, const FString& NewSaveGameName)
+{
+	FScopeLock Lock(&GetManifestLock());
+	for (auto& Manifest : LoadSlotManifests(NewSaveGameName))
+	{
+		// Dependants read cells by base slot name, rebasing keeps them small.
+		for (const auto& Dependant : Manifest.Dependants)
+		{
+			const FString DependantFolder = MakeLevelsFolder(Dependant, Manifest.LevelsFolderName);
+			FStreamingLevelSaveSlotManifest DependantManifest;
+			if (DependantManifest.Load(DependantFolder) && DependantManifest.BaseSlot == OldSaveGameName)
+			{
+				DependantManifest.BaseSlot = NewSaveGameName;
+				DependantManifest.Save(DependantFolder);
+			}
+		}
+
+		UpdateDependantIndex(Manifest.BaseSlot, Manifest.LevelsFolderName, OldSaveGameName, NewSaveGameName);
+		Manifest.SlotName = NewSaveGameName;
+		Manifest.Save(Manifest.GetLevelsFolder());
+	}
+}
+
+FCriticalSection& FStreamingLevelSaveSlot::GetManifestLock()
+{
+	static FCriticalSection ManifestLock;
+	return ManifestLock;
+}
+
+void FStreamingLevelSaveSlot::SetScheduler(const TSharedPtr<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe>& InScheduler)
+{
+	FScopeLock Lock(&MaintenanceSchedulerLock);
+	MaintenanceScheduler = InScheduler;
+}
+
+UE::Tasks::FTask FStreamingLevelSaveSlot::EnqueueMaintenance(const FString& SaveGameName, TUniqueFunction<void()>&& Work)
+{
+	TSharedPtr<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe> Scheduler;
+	{
+		FScopeLock Lock(&MaintenanceSchedulerLock);
+		Scheduler = MaintenanceScheduler.Pin();
+	}
+
+	if (!Scheduler)
+	{
+		Work();
+		return UE::Tasks::FTask();
+	}
+	return Scheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, MakeSlotKey(SaveGameName), MoveTemp(Work));
+}
+
+FString FStreamingLevelSaveSlot::MakeSlotKey(const FString& SaveGameName)
+{
+	return TEXT("Slot:") + SaveGameName;
+}
+
+FString FStreamingLevelSaveSlot::GetCellStoreDir()
+{
+	return FPaths::ProjectSavedDir() + "SaveGames/_CellStore/";
+}
+
+FString FStreamingLevelSaveSlot::MakeCellStorePath(uint64 Hash)
+{
+	return GetCellStoreDir() + FString::Printf(TEXT("%016llx.sav"), Hash);
+}
+
+bool FStreamingLevelSaveSlot::AddToCellStore(const FString& SourcePath, uint64 Hash, const FStreamingLevelSaveCellDigest& Digest,
+	EStreamingLevelSaveDurability Durability)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString StorePath = MakeCellStorePath(Hash);
+	if (PlatformFile.FileExists(*StorePath))
+	{
+		// Same hash is not same cell, compare before sharing it.
+		uint64 StoredHash = 0;
+		FStreamingLevelSaveCellDigest StoredDigest;
+		if (PlatformFile.FileSize(*StorePath) == Digest.Size && DigestFile(StorePath, StoredHash, StoredDigest) && StoredDigest == Digest)
+		{
+			return true;
+		}
+
+		UE_LOG(LogStreamingLevelSave, Log, TEXT("Cell store hash %016llx collides, %s is stored by its slot."), Hash, *SourcePath);
+		return false;
+	}
+
+	// Copy aside first, a stored cell is never partially written.
+	const FString PartialPath = StorePath + TEXT(".tmp");
+	PlatformFile.CreateDirectoryTree(*GetCellStoreDir());
+	if (!PlatformFile.CopyFile(*PartialPath, *SourcePath))
+	{
+		return false;
+	}
+	if (Durability != EStreamingLevelSaveDurability::None && !FStreamingLevelSaveFileWriter::FlushFile(PartialPath))
+	{
+		return false;
+	}
+	return PlatformFile.MoveFile(*StorePath, *PartialPath);
+}
+
+void FStreamingLevelSaveSlot::CollectGarbage()
+{
+	FScopeLock Lock(&GetCellStoreLock());
+
+	// Store stays empty unless a content addressed slot was saved, other storage modes skip reading manifests.
+	TArray<FString> StoredFiles;
+	IFileManager::Get().FindFiles(StoredFiles, *GetCellStoreDir());
+	if (StoredFiles.IsEmpty())
+	{
+		return;
+	}
+
+	TMap<uint64, int32> RefCounts;
+	for (const auto& Itr : FindManifestFiles())
+	{
+		FStreamingLevelSaveSlotManifest Manifest;
+		if (Manifest.Load(FPaths::GetPath(Itr)) && Manifest.bContentAddressed)
+		{
+			for (const auto& Pair : Manifest.CellHashes)
+			{
+				++RefCounts.FindOrAdd(Pair.Value);
+			}
+		}
+	}
+
+	for (const auto& Itr : StoredFiles)
+	{
+		const uint64 Hash = FCString::Strtoui64(*FPaths::GetBaseFilename(Itr), nullptr, 16);
+		if (RefCounts.FindRef(Hash) == 0)
+		{
+			IFileManager::Get().Delete(*(GetCellStoreDir() + Itr), false, false, true);
+		}
+	}
+}
+
+FCriticalSection& FStreamingLevelSaveSlot::GetCellStoreLock()
+{
+	static FCriticalSection CellStoreLock;
+	return CellStoreLock;
+}
+
+FString FStreamingLevelSaveSlot::FindStoredCell(const FStreamingLevelSaveSlotManifest& Manifest, const FString& CellFileName)
+{
+	FStreamingLevelSaveSlotManifest Current = Manifest;
+	for (int32 Depth = 0; Depth < MaxSlotChainWalk; ++Depth)
+	{
+		// Content addressed slots store a cell themselves if its hash collided in cell store.
+		if (Current.bContentAddressed && !Current.StoredCells.Contains(CellFileName))
+		{
+			const auto Hash = Current.CellHashes.Find(CellFileName);
+			return Hash ? MakeCellStorePath(*Hash) : FString();
+		}
+		
+		if (Current.StoredCells.Contains(CellFileName))
+		{
+			return Current.GetLevelsFolder() / CellFileName;
+		}
+
+		if (!Current.IsDifferential())
+		{
+			break;
+		}
+
+		FStreamingLevelSaveSlotManifest Base;
+		if (!Base.Load(MakeLevelsFolder(Current.BaseSlot, Current.LevelsFolderName)))
+		{
+			break;
+		}
+		Current = MoveTemp(Base);
+	}
+
+	return FString();
+}
+
+TArray<FString> FStreamingLevelSaveSlot::FindManifestFiles()
+{
+	// Catalogue lists files of every slot, save games folder is not walked.
+	FStreamingLevelSaveCatalogue::Refresh();
+	TArray<FString> ManifestFiles;
+	for (const auto& Entry : FStreamingLevelSaveCatalogue::GetAllEntries())
+	{
+		for (const auto& Itr : Entry.NestedFiles)
+		{
+			if (FPaths::GetCleanFilename(Itr) == FStreamingLevelSaveSlotManifest::FileName)
+			{
+				ManifestFiles.Add(UStreamingLevelSaveLibrary::MakeSaveGameDir(Entry.SlotName) + Itr);
+			}
+		}
+	}
+	return ManifestFiles;
+}
+
+TArray<FStreamingLevelSaveSlotManifest> FStreamingLevelSaveSlot::LoadSlotManifests(const FString& SaveGameName)
+{
+	TArray<FString> ManifestFiles;
+	IFileManager::Get().FindFilesRecursive(ManifestFiles, *UStreamingLevelSaveLibrary::MakeSaveGameFolder(SaveGameName),
+		FStreamingLevelSaveSlotManifest::FileName, true, false);
+
+	TArray<FStreamingLevelSaveSlotManifest> Manifests;
+	for (const auto& Itr : ManifestFiles)
+	{
+		// Staging and old copies sit next to levels folder.
+		const FString LevelsFolder = FPaths::GetPath(Itr);
+		FStreamingLevelSaveSlotManifest Manifest;
+		if (Manifest.Load(LevelsFolder) && FPaths::IsSamePath(LevelsFolder, MakeLevelsFolder(SaveGameName, Manifest.LevelsFolderName)))
+		{
+			Manifests.Add(MoveTemp(Manifest));
+		}
+	}
+	return Manifests;
+}
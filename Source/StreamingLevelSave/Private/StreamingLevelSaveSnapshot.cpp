@@ -0,0 +1,259 @@
+﻿#include "StreamingLevelSaveSnapshot.h"
+
+#include "StreamingLevelSave.h"
+#include "StreamingLevelSaveCatalogue.h"
+#include "StreamingLevelSaveFileWriter.h"
+#include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveSlot.h"
+#include "HAL/PlatformFileManager.h"
+
+FStreamingLevelSaveSnapshot::FStreamingLevelSaveSnapshot(int32 InVersion, const FString& InSaveGameName,
+	const FString& InLevelsFolderName, EStreamingLevelSaveSlotStorage InStorage, const FString& InBaseSlot, int32 InMaxChainLength)
+	: Version(InVersion)
+	, SaveGameName(InSaveGameName)
+	, LevelsFolderName(InLevelsFolderName)
+	, Storage(InStorage)
+	, BaseSlot(InBaseSlot)
+	, MaxChainLength(InMaxChainLength)
+	, TempDir(UStreamingLevelSaveLibrary::GetTempFileDir())
+	, PreservedFolder(UStreamingLevelSaveLibrary::GetTempFileFolder() + "_Snapshot" + FString::FromInt(InVersion))
+{
+}
+
+FStreamingLevelSaveSnapshot::~FStreamingLevelSaveSnapshot()
+{
+	IFileManager::Get().DeleteDirectory(*PreservedFolder, false, true);
+}
+
+void FStreamingLevelSaveSnapshot::Capture(const TArray<FString>& WritingLevelNames)
+{
+	TArray<FString> TempFiles;
+	IFileManager::Get().FindFiles(TempFiles, *UStreamingLevelSaveLibrary::GetTempFileFolder());
+
+	FScopeLock Lock(&Mutex);
+	PendingFiles.Append(TempFiles);
+	for (const auto& Itr : WritingLevelNames)
+	{
+		PendingFiles.Add(GetFileName(Itr));
+	}
+}
+
+void FStreamingLevelSaveSnapshot::PreserveFile(const FString& LevelStreamingName)
+{
+	const FString FileName = GetFileName(LevelStreamingName);
+
+	FScopeLock Lock(&Mutex);
+	if (!PendingFiles.Contains(FileName))
+	{
+		return;
+	}
+
+	// Only the first overwrite holds snapshot version.
+	IFileManager& FileManager = IFileManager::Get();
+	const FString PreservedPath = PreservedFolder / FileName;
+	const FString TempPath = TempDir + FileName;
+	if (!FileManager.FileExists(*PreservedPath) && FileManager.FileExists(*TempPath))
+	{
+		FileManager.Move(*PreservedPath, *TempPath);
+	}
+}
+
+bool FStreamingLevelSaveSnapshot::CopyToSaveFolder()
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SaveFolder = FStreamingLevelSaveSlot::MakeLevelsFolder(SaveGameName, LevelsFolderName);
+
+	// Slots based on this one keep their cells.
+	FStreamingLevelSaveSlot::DetachDependants(SaveGameName);
+	FStreamingLevelSaveSlotManifest PreviousManifest;
+	const bool bHadManifest = PreviousManifest.Load(SaveFolder);
+
+	FStreamingLevelSaveSlotManifest BaseManifest;
+	const bool bContentAddressed = Storage == EStreamingLevelSaveSlotStorage::ContentAddressed;
+	const bool bDifferential = Storage == EStreamingLevelSaveSlotStorage::Differential
+		&& !BaseSlot.IsEmpty() && BaseSlot != SaveGameName
+		&& BaseManifest.Load(FStreamingLevelSaveSlot::MakeLevelsFolder(BaseSlot, LevelsFolderName));
+
+	// Staged, differential and content addressed slots fill a staging folder, slot keeps its previous files until it is swapped in.
+	// Content addressed slot must keep its manifest, else garbage collection drops its stored cells.
+	FStreamingLevelSaveFileWriter Writer(GetDefault<UStreamingLevelSaveSettings>()->Durability);
+	const bool bStaged = Writer.GetDurability() == EStreamingLevelSaveDurability::Staged || bDifferential || bContentAddressed;
+	const FString WriteFolder = bStaged ? FStreamingLevelSaveFileWriter::GetStagingFolder(SaveFolder) : SaveFolder;
+	if (bStaged)
+	{
+		// Old cells of this slot must not shadow base or stored cells.
+		PlatformFile.DeleteDirectoryRecursively(*WriteFolder);
+	}
+	
+	if (!PlatformFile.DirectoryExists(*WriteFolder) && !PlatformFile.CreateDirectoryTree(*WriteFolder))
+	{
+		return false;
+	}
+
+	FStreamingLevelSaveSlotManifest Manifest;
+	Manifest.SlotName = SaveGameName;
+	Manifest.LevelsFolderName = LevelsFolderName;
+	Manifest.bContentAddressed = bContentAddressed;
+	if (bDifferential)
+	{
+		Manifest.BaseSlot = BaseSlot;
+		Manifest.ChainLength = BaseManifest.ChainLength + 1;
+	}
+
+	TArray<FString> Files;
+	{
+		FScopeLock Lock(&Mutex);
+		Files = PendingFiles.Array();
+	}
+
+	TOptional<FScopeLock> CellStoreLock;
+	if (bContentAddressed)
+	{
+		CellStoreLock.Emplace(&FStreamingLevelSaveSlot::GetCellStoreLock());
+	}
+
+	if (Progress)
+	{
+		Progress->CellsTotal = Files.Num();
+	}
+
+	bool bSuccess = true;
+	bool bCancelled = false;
+	for (const auto& FileName : Files)
+	{
+		if (Progress && Progress->bCancelled)
+		{
+			bSuccess = false;
+			bCancelled = true;
+			break;
+		}
+
+		// Hold lock per file, so writer cannot move or overwrite it while copying.
+		FScopeLock Lock(&Mutex);
+		PendingFiles.Remove(FileName);
+		const FString PreservedPath = PreservedFolder / FileName;
+		const FString SourcePath = PlatformFile.FileExists(*PreservedPath)
+			? PreservedPath
+			: TempDir + FileName;
+		if (!PlatformFile.FileExists(*SourcePath))
+		{
+			// Nothing to copy.
+			if (Progress)
+			{
+				++Progress->CellsDone;
+			}
+			continue;
+		}
+
+		uint64 Hash = 0;
+		FStreamingLevelSaveCellDigest Digest;
+		if (!FStreamingLevelSaveSlot::DigestFile(SourcePath, Hash, Digest))
+		{
+			UE_LOG(LogStreamingLevelSave, Warning, TEXT("Save snapshot %d failed to read %s."), Version, *FileName);
+			bSuccess = false;
+			continue;
+		}
+		Manifest.CellHashes.Add(FileName, Hash);
+		Manifest.CellDigests.Add(FileName, Digest);
+
+		// Cell is done once it is read from base chain, stored or copied, not when its copy starts.
+		const auto ReportDone = [this, &Digest]()
+		{
+			if (Progress)
+			{
+				++Progress->CellsDone;
+				Progress->BytesDone += Digest.Size;
+			}
+		};
+
+		// Unchanged cells are read from base chain.
+		const auto BaseDigest = BaseManifest.CellDigests.Find(FileName);
+		if (bDifferential && BaseManifest.CellHashes.FindRef(FileName) == Hash && BaseDigest && *BaseDigest == Digest)
+		{
+			ReportDone();
+			continue;
+		}
+
+		// Slot stores cell itself if its hash collides in cell store.
+		if (bContentAddressed && FStreamingLevelSaveSlot::AddToCellStore(SourcePath, Hash, Digest, Writer.GetDurability()))
+		{
+			ReportDone();
+			continue;
+		}
+
+		if (Writer.Copy(WriteFolder / FileName, SourcePath))
+		{
+			Manifest.StoredCells.Add(FileName);
+			ReportDone();
+		}
+		else
+		{
+			UE_LOG(LogStreamingLevelSave, Warning, TEXT("Save snapshot %d failed to copy %s."), Version, *FileName);
+			bSuccess = false;
+		}
+	}
+
+	// Other slots update dependants index of this one, hold until new manifest is in place.
+	FScopeLock ManifestLock(&FStreamingLevelSaveSlot::GetManifestLock());
+
+	// Manifest of a cancelled copy would list only copied cells.
+	if (!bCancelled)
+	{
+		// Dependants which could not be detached, or were saved since, stay indexed.
+		Manifest.Dependants = PreviousManifest.Dependants;
+		FStreamingLevelSaveSlotManifest LiveManifest;
+		if (LiveManifest.Load(SaveFolder))
+		{
+			Manifest.Dependants.Append(LiveManifest.Dependants);
+		}
+		bSuccess &= Manifest.Save(WriteFolder, Writer);
+		bSuccess &= Writer.Commit();
+	}
+	if (bStaged)
+	{
+		if (bSuccess)
+		{
+			bSuccess = FStreamingLevelSaveFileWriter::SwapInStagingFolder(SaveFolder);
+		}
+		else
+		{
+			PlatformFile.DeleteDirectoryRecursively(*WriteFolder);
+		}
+	}
+
+	if (bSuccess)
+	{
+		if (bHadManifest && PreviousManifest.BaseSlot != Manifest.BaseSlot)
+		{
+			FStreamingLevelSaveSlot::UpdateDependantIndex(PreviousManifest.BaseSlot, LevelsFolderName, SaveGameName, FString());
+		}
+		FStreamingLevelSaveSlot::UpdateDependantIndex(Manifest.BaseSlot, LevelsFolderName, FString(), SaveGameName);
+	}
+	ManifestLock.Unlock();
+
+	// Cells only the previous version of this slot referenced. Catalogue lists new manifest before store is unlocked.
+	if (bContentAddressed)
+	{
+		FStreamingLevelSaveCatalogue::UpdateSlot(SaveGameName);
+		CellStoreLock.Reset();
+		FStreamingLevelSaveSlot::CollectGarbage();
+	}
+
+	if (Progress && !bSuccess)
+	{
+		Progress->bFailed = true;
+	}
+
+	// Keep chains short, loading walks them.
+	if (bSuccess && Manifest.IsDifferential() && Manifest.ChainLength >= MaxChainLength)
+	{
+		FStreamingLevelSaveSlot::Compact(SaveGameName, LevelsFolderName);
+	}
+
+	return bSuccess;
+}
+
+FString FStreamingLevelSaveSnapshot::GetFileName(const FString& LevelStreamingName)
+{
+	return FPaths::GetCleanFilename(UStreamingLevelSaveLibrary::MakeTempFilePath(LevelStreamingName));
+}
@@ -1,13 +1,30 @@
 ﻿#include "StreamingLevelSaveSubsystem.h"
 
+#include "IImageWrapperModule.h"
 #include "ImageUtils.h"
+#include "StreamingLevelSave.h"
+#include "StreamingLevelSaveCatalogue.h"
+#include "StreamingLevelSaveCellFile.h"
 #include "StreamingLevelSaveComponent.h"
+#include "StreamingLevelSaveFileWriter.h"
 #include "StreamingLevelSaveInterface.h"
+#include "StreamingLevelSaveIOScheduler.h"
 #include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveRecorder.h"
 #include "StreamingLevelSaveSequence.h"
 #include "StreamingLevelSaveSettings.h"
+#include "StreamingLevelSaveSlot.h"
+#include "StreamingLevelSaveSnapshot.h"
+#include "StreamingLevelSaveStats.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/LevelStreaming.h"
+#include "Hash/CityHash.h"
 #include "Kismet/GameplayStatics.h"
+#include "WorldPartition/WorldPartitionLevelStreamingDynamic.h"
 #include "WorldPartition/WorldPartitionRuntimeCell.h"
+#include "WorldPartition/WorldPartitionSubsystem.h"
 
 #define LIBRARY UStreamingLevelSaveLibrary
 #define SETTINGS UStreamingLevelSaveSettings
@@ -31,9 +48,45 @@ FStreamingLevelSaveData* UStreamingLevelSaveSubsystem::GetOrAddCellSaveData(cons
 
 FStreamingLevelSaveData* UStreamingLevelSaveSubsystem::GetOrAddTempCellSaveData(const FString& CellName)
 {
+	ReclaimTempData(CellName);
 	return GetOrAddCellSaveData(CellName, TempSaveDatas);
 }
 
+FStreamingLevelSaveData* UStreamingLevelSaveSubsystem::FindTempData(const FString& CellName)
+{
+	ReclaimTempData(CellName);
+	return TempSaveDatas.Find(CellName);
+}
+
+void UStreamingLevelSaveSubsystem::ReclaimTempData(const FString& CellName)
+{
+	FLentTempData Lent;
+	if (LentTempDatas.Num() == 0 || !LentTempDatas.RemoveAndCopyValue(CellName, Lent))
+	{
+		return;
+	}
+
+	if (!Lent.Write.IsCompleted())
+	{
+		IOScheduler->Promote(CellName, EStreamingLevelSaveIOPriority::UrgentRead);
+		Lent.Write.Wait();
+	}
+	// Every access reclaims first, nothing was added for this cell while lent.
+	TempSaveDatas.Add(CellName, MoveTemp(*Lent.Data));
+}
+
+void UStreamingLevelSaveSubsystem::ReclaimWrittenTempDatas()
+{
+	for (auto It = LentTempDatas.CreateIterator(); It; ++It)
+	{
+		if (It->Value.Write.IsCompleted())
+		{
+			TempSaveDatas.Add(It->Key, MoveTemp(*It->Value.Data));
+			It.RemoveCurrent();
+		}
+	}
+}
+
 void UStreamingLevelSaveSubsystem::BeginSaveLoadSequence(FString SaveFileName, bool bSaving, bool bMultiplay, bool bLan)
 {
 	if (!IsSaving() && !IsLoading())
@@ -52,6 +105,12 @@ void UStreamingLevelSaveSubsystem::BeginSaveLoadSequence(FString SaveFileName, b
 		SaveLoadSequence->bProgressing = true;
 		SaveLoadSequence->bMultiplay = bMultiplay;
 		SaveLoadSequence->bLan = bLan;
+		SequenceProgress = MakeShared<FStreamingLevelSaveProgress, ESPMode::ThreadSafe>();
+		SessionRecorder.Record(EStreamingLevelSaveRecordEvent::BeginSequence, SaveFileName,
+			bSaving ? EStreamingLevelSaveRecordFlags::Saving : EStreamingLevelSaveRecordFlags::None);
+		
+		// Sequence saves or replaces every cell itself.
+		CancelAutosave();
 		
 		// Call level saving and loading at begin.
 		if (bSaving)
@@ -68,8 +127,17 @@ void UStreamingLevelSaveSubsystem::BeginSaveLoadSequence(FString SaveFileName, b
 			if (SaveLoadSequence->CheckSaveFileNameValid(SaveFileName))
 			{
 				SetCurrentSaveSlotName(SaveFileName);
-				SaveLoadSequence->CopySaveFilesToTempPath();
-				SaveLoadSequence->BeginLoad();
+				DifferentialBaseSlot = SaveFileName;
+				
+				// Copy slot on a worker, Tick begins load once temp files are in place.
+				LoadCopyTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, FStreamingLevelSaveSlot::MakeSlotKey(SaveFileName),
+					[SaveFileName, LevelsSaveFolder = SaveLoadSequence->LevelsSaveFolder, Progress = SequenceProgress]()
+				{
+					if (!UStreamingLevelSaveSequence::CopySaveFilesToTempPath(SaveFileName, LevelsSaveFolder, Progress.Get()))
+					{
+						Progress->bFailed = true;
+					}
+				});
 			}
 			else
 			{
@@ -82,12 +150,66 @@ void UStreamingLevelSaveSubsystem::BeginSaveLoadSequence(FString SaveFileName, b
 
 void UStreamingLevelSaveSubsystem::EndSaveLoadSequence()
 {
+	// Save completes once snapshot is durable in save folder, Tick finishes it.
+	if (SaveSnapshotTask.IsValid() && !SaveSnapshotTask.IsCompleted())
+	{
+		bSequenceEndPending = true;
+		return;
+	}
+
+	FinishSaveLoadSequence();
+}
+
+bool UStreamingLevelSaveSubsystem::CancelSaveLoadSequence()
+{
+	// Only file copies can be cancelled, a loaded or durable slot stays so.
+	const bool bCopying = LoadCopyTask.IsValid() || (SaveSnapshotTask.IsValid() && !SaveSnapshotTask.IsCompleted());
+	if (!SaveLoadSequence || !SaveLoadSequence->bProgressing || !SequenceProgress || !bCopying)
+	{
+		return false;
+	}
+
+	SequenceProgress->bCancelled = true;
+	return true;
+}
+
+void UStreamingLevelSaveSubsystem::GetSaveLoadProgress(int32& CellsDone, int32& CellsTotal, int64& BytesDone) const
+{
+	CellsDone = SequenceProgress ? SequenceProgress->CellsDone.load() : 0;
+	CellsTotal = SequenceProgress ? SequenceProgress->CellsTotal.load() : 0;
+	BytesDone = SequenceProgress ? SequenceProgress->BytesDone.load() : 0;
+}
+
+void UStreamingLevelSaveSubsystem::FinishSaveLoadSequence()
+{
+	bSequenceEndPending = false;
+	// Catalogue scans slot folder, it must see copied snapshot.
+	const UE::Tasks::FTask SnapshotTask = SaveSnapshotTask;
+	WaitForSaveSnapshot();
+	if (LoadCopyTask.IsValid())
+	{
+		LoadCopyTask.Wait();
+		LoadCopyTask = UE::Tasks::FTask();
+	}
+	
 	if (SaveLoadSequence)
 	{
 		SaveLoadSequence->bProgressing = false;
+		SessionRecorder.Record(EStreamingLevelSaveRecordEvent::EndSequence, SaveLoadSequence->SaveFileName,
+			SaveLoadSequence->bSaving ? EStreamingLevelSaveRecordFlags::Saving : EStreamingLevelSaveRecordFlags::None);
 		
-		if (SaveLoadSequence->bSaving)
+		if (SequenceProgress && (SequenceProgress->bCancelled || SequenceProgress->bFailed))
 		{
+			OnSaveLoadFailed.Broadcast();
+		}
+		else if (SaveLoadSequence->bSaving)
+		{
+			IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, FStreamingLevelSaveSlot::MakeSlotKey(SaveLoadSequence->SaveFileName),
+				[SlotName = SaveLoadSequence->SaveFileName, MetaData = SaveLoadSequence->CatalogueMetaData,
+					Thumbnail = SaveLoadSequence->CatalogueThumbnail.Data]()
+			{
+				FStreamingLevelSaveCatalogue::UpdateSlot(SlotName, &MetaData, &Thumbnail);
+			}, UE_DOUBLE_BIG_NUMBER, SnapshotTask.IsValid() ? MakeArrayView(&SnapshotTask, 1) : TConstArrayView<UE::Tasks::FTask>());
 			OnSaveComplete.Broadcast();
 		}
 		else
@@ -124,11 +246,251 @@ bool UStreamingLevelSaveSubsystem::IsLoading() const
 		return true;
 	}
 	
-	return false;
+	return bQuickLoading;
+}
+
+void UStreamingLevelSaveSubsystem::QuickSave()
+{
+	if (IsSaving() || IsLoading() || !IsAllowSaving())
+	{
+		return;
+	}
+
+	// Capture visible levels now, capturing may add temp datas so find them after. Captured datas are not lent.
+	TArray<FString> CapturedNames;
+	for (const auto Level : VisibleStreamingLevels)
+	{
+		if (CaptureLevelInternal(Level, true))
+		{
+			CapturedNames.Add(LIBRARY::GetLevelName(Level));
+		}
+	}
+
+	const auto Snapshot = MakeShared<FStreamingLevelSaveQuickSnapshot>();
+	Snapshot->Time = FDateTime::Now();
+
+	// Encode visible levels straight from their temp datas in parallel, datas stay in place and are not copied.
+	// Reserved, added cells do not move while encoding.
+	TArray<TPair<FStreamingLevelSaveData*, TArray<uint8>*>> Encodes;
+	Snapshot->Cells.Reserve(CapturedNames.Num());
+	for (const auto& Name : CapturedNames)
+	{
+		if (const auto Found = TempSaveDatas.Find(Name))
+		{
+			Encodes.Emplace(Found, &Snapshot->Cells.Add(Name));
+		}
+	}
+	ParallelFor(Encodes.Num(), [&Encodes](int32 Index)
+	{
+		FStreamingLevelSaveCellFile::SaveToMemory(*Encodes[Index].Value, *Encodes[Index].Key);
+	});
+
+	TArray<UE::Tasks::FTask> Prerequisites;
+	PendingWrites.GenerateValueArray(Prerequisites);
+	const FString TempFolder = LIBRARY::GetTempFileFolder();
+	const FString TempDir = LIBRARY::GetTempFileDir();
+	Snapshot->BuildTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::UnloadWrite, FString(), [Snapshot, TempFolder, TempDir]()
+	{
+		// Unloaded levels, their temp files are already encoded.
+		TArray<FString> TempFiles;
+		IFileManager::Get().FindFiles(TempFiles, *TempFolder);
+		for (const auto& FileName : TempFiles)
+		{
+			const FString LevelName = FPaths::GetBaseFilename(FileName);
+			if (!Snapshot->Cells.Contains(LevelName))
+			{
+				FFileHelper::LoadFileToArray(Snapshot->Cells.Add(LevelName), *(TempDir + FileName));
+			}
+		}
+	}, UE_DOUBLE_BIG_NUMBER, Prerequisites);
+
+	QuickSnapshots.Insert(Snapshot, 0);
+	const int32 MaxSnapshots = FMath::Max(GetDefault<UStreamingLevelSaveSettings>()->MaxQuickSaveSnapshots, 1);
+	if (QuickSnapshots.Num() > MaxSnapshots)
+	{
+		QuickSnapshots.SetNum(MaxSnapshots);
+	}
+}
+
+bool UStreamingLevelSaveSubsystem::QuickLoad(int32 SnapshotIndex)
+{
+	if (IsSaving() || IsLoading() || !QuickSnapshots.IsValidIndex(SnapshotIndex))
+	{
+		return false;
+	}
+
+	const auto Snapshot = QuickSnapshots[SnapshotIndex];
+	Snapshot->BuildTask.Wait();
+
+	// Decode visible levels first, a destroyed actor can not come back without reloading its level.
+	TMap<const ULevel*, FStreamingLevelSaveData> Restores;
+	bool bReopenMap = false;
+	for (const auto Level : VisibleStreamingLevels)
+	{
+		const auto LevelName = LIBRARY::GetLevelName(Level);
+		auto& Saved = Restores.Add(Level);
+		if (const auto Cell = Snapshot->Cells.Find(LevelName))
+		{
+			FStreamingLevelSaveCellFile::LoadFromMemory(*Cell, LevelName, Saved);
+		}
+
+		TSet<FGuid> SavedDestroyed;
+		TSet<FGuid> CurrentDestroyed;
+		GatherDestroyedActors(Saved, SavedDestroyed);
+		if (const auto Current = FindTempData(LevelName))
+		{
+			GatherDestroyedActors(*Current, CurrentDestroyed);
+		}
+		if (!SavedDestroyed.Includes(CurrentDestroyed))
+		{
+			bReopenMap = true;
+			break;
+		}
+	}
+
+	OnPreLoad.Broadcast();
+	if (!bReopenMap)
+	{
+		// Runtime actors of visible cells are spawned again from snapshot.
+		for (const auto Itr : RuntimeActorComponents.Array())
+		{
+			if (IsValid(Itr) && FindRuntimeActorLevel(Itr->GetOwner()))
+			{
+				ReleaseRuntimeActor(Itr, true);
+			}
+		}
+	}
+	ClearAllTempFiles();
+
+	// Levels decode straight from snapshot while streaming in. Temp files are written behind for the others,
+	// scheduler keeps later writes and reads of each level after them.
+	bQuickLoading = true;
+	QuickLoadSnapshot = Snapshot;
+	for (const auto& Pair : Snapshot->Cells)
+	{
+		QuickLoadPendingCells.Add(Pair.Key);
+		PendingWrites.Add(Pair.Key, IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::UnloadWrite, Pair.Key,
+			[Snapshot, LevelName = Pair.Key, FilePath = LIBRARY::MakeTempFilePath(Pair.Key)]()
+		{
+			FFileHelper::SaveArrayToFile(Snapshot->Cells[LevelName], *FilePath);
+		}));
+	}
+
+	if (bReopenMap)
+	{
+		// Reopen current map, saving is skipped until it is loaded.
+		UGameplayStatics::OpenLevel(GetWorld(), FName(*UGameplayStatics::GetCurrentLevelName(GetWorld())));
+		return true;
+	}
+
+	// Restore as if visible levels had just streamed in with decoded data.
+	for (auto& Pair : Restores)
+	{
+		const auto LevelName = LIBRARY::GetLevelName(Pair.Key);
+		QuickLoadPendingCells.Remove(LevelName);
+		if (const auto Ptr = GetOrAddTempCellSaveData(LevelName))
+		{
+			*Ptr = MoveTemp(Pair.Value);
+			PreloadedLevelNames.Add(LevelName);
+			LoadLevelInternal(Pair.Key);
+		}
+	}
+
+	bQuickLoading = false;
+	OnLoadComplete.Broadcast();
+	return true;
+}
+
+void UStreamingLevelSaveSubsystem::FlushQuickSave(int32 SnapshotIndex, FString SaveFileName)
+{
+	if (!QuickSnapshots.IsValidIndex(SnapshotIndex) || !SaveLoadSequence)
+	{
+		return;
+	}
+
+	const auto Snapshot = QuickSnapshots[SnapshotIndex];
+	const FString LevelsFolderName = SaveLoadSequence->LevelsSaveFolder;
+	const FString SaveFolder = LIBRARY::MakeSaveGameDir(SaveFileName) + LevelsFolderName;
+	const auto Durability = GetDefault<UStreamingLevelSaveSettings>()->Durability;
+	IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, FStreamingLevelSaveSlot::MakeSlotKey(SaveFileName),
+		[Snapshot, SaveFileName, LevelsFolderName, SaveFolder, Durability]()
+	{
+		// Written as a full slot, slots based on it keep their cells.
+		FStreamingLevelSaveSlot::DetachDependants(SaveFileName);
+
+		// Snapshot holds every cell, staged write replaces whole folder.
+		FStreamingLevelSaveFileWriter Writer(Durability);
+		const bool bStaged = Durability == EStreamingLevelSaveDurability::Staged;
+		const FString WriteFolder = bStaged ? FStreamingLevelSaveFileWriter::GetStagingFolder(SaveFolder) : SaveFolder;
+		if (bStaged)
+		{
+			IFileManager::Get().DeleteDirectory(*WriteFolder, false, true);
+		}
+
+		FStreamingLevelSaveSlotManifest Manifest;
+		Manifest.SlotName = SaveFileName;
+		Manifest.LevelsFolderName = LevelsFolderName;
+		bool bSuccess = true;
+		for (const auto& Pair : Snapshot->Cells)
+		{
+			const FString FileName = FPaths::GetCleanFilename(LIBRARY::MakeTempFilePath(Pair.Key));
+			if (!Writer.Write(WriteFolder / FileName, Pair.Value))
+			{
+				UE_LOG(LogStreamingLevelSave, Warning, TEXT("Quick save failed to write %s."), *FileName);
+				bSuccess = false;
+				continue;
+			}
+
+			uint64 Hash = 0;
+			FStreamingLevelSaveCellDigest Digest;
+			FStreamingLevelSaveSlot::DigestBytes(Pair.Value, Hash, Digest);
+			Manifest.CellHashes.Add(FileName, Hash);
+			Manifest.CellDigests.Add(FileName, Digest);
+			Manifest.StoredCells.Add(FileName);
+		}
+		bSuccess &= Writer.Commit();
+
+		// Manifest is written last, until then slot keeps describing its previous cells.
+		FScopeLock ManifestLock(&FStreamingLevelSaveSlot::GetManifestLock());
+		FStreamingLevelSaveSlotManifest PreviousManifest;
+		const bool bHadManifest = PreviousManifest.Load(SaveFolder);
+		if (bSuccess)
+		{
+			Manifest.Dependants = PreviousManifest.Dependants;
+			bSuccess = Manifest.Save(WriteFolder, Writer) && Writer.Commit();
+		}
+		if (bStaged)
+		{
+			if (bSuccess)
+			{
+				bSuccess = FStreamingLevelSaveFileWriter::SwapInStagingFolder(SaveFolder);
+			}
+			else
+			{
+				IFileManager::Get().DeleteDirectory(*WriteFolder, false, true);
+			}
+		}
+		if (bSuccess && bHadManifest)
+		{
+			FStreamingLevelSaveSlot::UpdateDependantIndex(PreviousManifest.BaseSlot, LevelsFolderName, SaveFileName, FString());
+		}
+		ManifestLock.Unlock();
+
+		FStreamingLevelSaveCatalogue::UpdateSlot(SaveFileName);
+		FStreamingLevelSaveSlot::CollectGarbage();
+	}, UE_DOUBLE_BIG_NUMBER, MakeArrayView(&Snapshot->BuildTask, 1));
+}
+
+int32 UStreamingLevelSaveSubsystem::GetNumQuickSaves() const
+{
+	return QuickSnapshots.Num();
 }
 
 TArray<FString> UStreamingLevelSaveSubsystem::CollectTempSaveFiles()
 {
+	// Unloaded levels may still be writing.
+	WaitForPendingWrites();
+	
 	// Save levels.
 	for (const auto Level : VisibleStreamingLevels)
 	{
@@ -142,44 +504,118 @@ TArray<FString> UStreamingLevelSaveSubsystem::CollectTempSaveFiles()
 	return TempFiles;
 }
 
+void UStreamingLevelSaveSubsystem::BeginSaveSnapshot(const FString& SaveGameName, const FString& LevelsFolderName)
+{
+	WaitForSaveSnapshot();
+	
+	// Visible levels are captured now and written on workers, as part of snapshot.
+	TArray<FString> WritingLevelNames;
+	for (const auto Level : VisibleStreamingLevels)
+	{
+		SaveLevelInternal(Level, true, true);
+	}
+	PendingWrites.GetKeys(WritingLevelNames);
+
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	const auto Snapshot = MakeShared<FStreamingLevelSaveSnapshot>(++SaveSnapshotVersion, SaveGameName, LevelsFolderName,
+		Settings->SlotStorage, DifferentialBaseSlot, Settings->MaxDifferentialChainLength);
+	Snapshot->SetProgress(SequenceProgress);
+	DifferentialBaseSlot = SaveGameName;
+	Snapshot->Capture(WritingLevelNames);
+
+	// Writes launched from now on preserve snapshot files first.
+	TArray<UE::Tasks::FTask> Prerequisites;
+	PendingWrites.GenerateValueArray(Prerequisites);
+	ActiveSaveSnapshot = Snapshot;
+	SaveSnapshotTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, FStreamingLevelSaveSlot::MakeSlotKey(SaveGameName), [Snapshot]()
+	{
+		Snapshot->CopyToSaveFolder();
+	}, UE_DOUBLE_BIG_NUMBER, Prerequisites);
+}
+
+void UStreamingLevelSaveSubsystem::WaitForSaveSnapshot()
+{
+	if (SaveSnapshotTask.IsValid())
+	{
+		SaveSnapshotTask.Wait();
+		SaveSnapshotTask = UE::Tasks::FTask();
+	}
+	ActiveSaveSnapshot.Reset();
+}
+
 TArray<FString> UStreamingLevelSaveSubsystem::FindMetaDataFiles(FString MetaDataFileName)
 {
+	// Save games outside slot folders, only save games folder itself is listed.
 	TArray<FString> Result;
-	const FString SaveGamesDir = FPaths::ProjectSavedDir() / TEXT("SaveGames");
-	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-	
-	if (!PlatformFile.DirectoryExists(*SaveGamesDir))
+	IFileManager::Get().FindFiles(Result, *(FPaths::ProjectSavedDir() / TEXT("SaveGames") / MetaDataFileName), true, false);
+	for (auto& Itr : Result)
 	{
-		return Result;
+		Itr = FPaths::GetBaseFilename(Itr);
 	}
-	
-	TArray<FString> TempFiles;
-	IFileManager::Get().FindFilesRecursive(TempFiles, *SaveGamesDir, *MetaDataFileName, true, false);
-	for (const auto Itr : TempFiles)
+
+	// Catalogue lists files of slots, slots written outside it, for example by SaveGameToSlot, are rescanned first.
+	FStreamingLevelSaveCatalogue::Refresh();
+	for (const auto& Entry : FStreamingLevelSaveCatalogue::GetAllEntries())
 	{
-		// Relative to save games folder.
-		FString RelativePath = Itr;
-		FPaths::MakePathRelativeTo(RelativePath, *SaveGamesDir);
-		// Remove extension and "SaveGames/".
-		RelativePath = FPaths::GetBaseFilename(RelativePath, false);
-		FString RightSplit;
-		RelativePath.Split("SaveGames/", nullptr, &RightSplit);
-		// Finish
-		Result.Add(RightSplit);
+		for (const auto& Itr : Entry.RootFiles)
+		{
+			if (Itr.MatchesWildcard(MetaDataFileName))
+			{
+				Result.Add(Entry.SlotName + "/" + FPaths::GetBaseFilename(Itr));
+			}
+		}
+		for (const auto& Itr : Entry.NestedFiles)
+		{
+			if (FPaths::GetCleanFilename(Itr).MatchesWildcard(MetaDataFileName))
+			{
+				Result.Add(Entry.SlotName + "/" + FPaths::GetBaseFilename(Itr, false));
+			}
+		}
 	}
 
 	return Result;
 }
 
+void UStreamingLevelSaveSubsystem::QuerySaveCatalogue(int32 PageIndex, int32 PageSize, FOnSaveCatalogueQueried OnQueried)
+{
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [PageIndex, PageSize, OnQueried]()
+	{
+		TArray<FStreamingLevelSaveCatalogueEntry> Entries;
+		const int32 TotalCount = FStreamingLevelSaveCatalogue::Query(PageIndex, PageSize, Entries);
+		AsyncTask(ENamedThreads::GameThread, [OnQueried, Entries = MoveTemp(Entries), TotalCount]()
+		{
+			OnQueried.ExecuteIfBound(Entries, TotalCount);
+		});
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
+}
+
+FSaveGameScreenshotData UStreamingLevelSaveSubsystem::LoadCatalogueThumbnail(const FStreamingLevelSaveCatalogueEntry& Entry)
+{
+	FSaveGameScreenshotData Result;
+	FStreamingLevelSaveCatalogue::LoadThumbnail(Entry, Result.Data);
+	return Result;
+}
+
 void UStreamingLevelSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
+
+	IOScheduler = MakeShared<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe>(GetDefault<UStreamingLevelSaveSettings>()->MaxConcurrentIOJobs);
+	// Deleting slots runs on same workers, ordered with slot copies.
+	FStreamingLevelSaveSlot::SetScheduler(IOScheduler);
+	// Workers encode and decode screenshots, they cannot load modules.
+	FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
 	
 	if (SETTINGS::GetEnableSaveLoad())
 	{
 		AssignDelegates();
 	}
 
+	if (GetDefault<UStreamingLevelSaveSettings>()->bRecordSessions)
+	{
+		SessionRecorder.Start(FStreamingLevelSaveRecorder::MakeSessionPath());
+	}
+
 	const auto Class = GetDefault<UStreamingLevelSaveSettings>()->GetDefaultSaveSequenceClass();
 	SaveLoadSequence = NewObject<UStreamingLevelSaveSequence>(this, Class);
 	SaveLoadSequence->SetSubsystem(this);
@@ -189,6 +625,10 @@ void UStreamingLevelSaveSubsystem::Deinitialize()
 {
 	Super::Deinitialize();
 
+	RuntimeActorPools.Empty();
+	PendingRestores.Empty();
+	WaitForSaveSnapshot();
+
 	if (SaveLoadSequence)
 	{
 		SaveLoadSequence->CleanUp();
@@ -197,6 +637,7 @@ void UStreamingLevelSaveSubsystem::Deinitialize()
 	}
 	
 	RemoveDelegates();
+	SessionRecorder.Stop();
 	
 	if (SETTINGS::GetClearTempFilesOnEndGame())
 	{
@@ -206,6 +647,16 @@ void UStreamingLevelSaveSubsystem::Deinitialize()
 
 void UStreamingLevelSaveSubsystem::Tick(float DeltaTime)
 {
+	TickSequence();
+	// Levels keep streaming while paused.
+	TickPendingFilters();
+
+	// Actors, lazy restores and autosave follow game time.
+	if (const UWorld* World = GetWorld(); World && World->IsPaused())
+	{
+		return;
+	}
+
 	// Stop runtime actors to get out of bound.
 	for (const auto Itr : RuntimeActorComponents)
 	{
@@ -231,6 +682,40 @@ void UStreamingLevelSaveSubsystem::Tick(float DeltaTime)
 			}
 		}
 	}
+
+	ReclaimWrittenTempDatas();
+	TickRuntimeActorDehydration();
+	TickLazyRestore(DeltaTime);
+	TickAutosave(DeltaTime);
+}
+
+void UStreamingLevelSaveSubsystem::TickSequence()
+{
+	// Slot is in temp folder, sequence can load it.
+	if (LoadCopyTask.IsValid() && LoadCopyTask.IsCompleted())
+	{
+		LoadCopyTask = UE::Tasks::FTask();
+		if (SequenceProgress->bCancelled || SequenceProgress->bFailed)
+		{
+			ClearAllTempFiles();
+			FinishSaveLoadSequence();
+		}
+		else
+		{
+			SaveLoadSequence->BeginLoad();
+		}
+	}
+
+	if (bSequenceEndPending && (!SaveSnapshotTask.IsValid() || SaveSnapshotTask.IsCompleted()))
+	{
+		FinishSaveLoadSequence();
+	}
+
+	// Snapshot copied everything, writers no longer need to preserve files.
+	if (SaveSnapshotTask.IsValid() && SaveSnapshotTask.IsCompleted())
+	{
+		WaitForSaveSnapshot();
+	}
 }
 
 TStatId UStreamingLevelSaveSubsystem::GetStatId() const
@@ -238,38 +723,25 @@ TStatId UStreamingLevelSaveSubsystem::GetStatId() const
 	RETURN_QUICK_DECLARE_CYCLE_STAT(UStreamingLevelSaveSubsystem, STATGROUP_Tickables);
 }
 
-bool UStreamingLevelSaveSubsystem::SaveTempData(const FString& LevelStreamingName, const FStreamingLevelSaveData& SaveData)
+bool UStreamingLevelSaveSubsystem::SaveTempData(const FString& LevelStreamingName, FStreamingLevelSaveData& SaveData)
 {
 	if (LevelStreamingName.IsEmpty()) return false;
 
-	TArray<uint8> Data;
-	FMemoryWriter MemoryWriter(Data, true);
-	FObjectAndNameAsStringProxyArchive WriterProxy(MemoryWriter, /*bInLoadIfFindFails*/false);
-	FStreamingLevelSaveData::StaticStruct()->SerializeBin(WriterProxy, &const_cast<FStreamingLevelSaveData&>(SaveData));
-	
 	const FString FilePath = LIBRARY::MakeTempFilePath(LevelStreamingName);
-	const bool bSuccess = FFileHelper::SaveArrayToFile(Data, *FilePath);
-
-	return bSuccess;
+	return FStreamingLevelSaveCellFile::Save(FilePath, SaveData);
 }
 
 bool UStreamingLevelSaveSubsystem::LoadTempData(const FString& LevelStreamingName, FStreamingLevelSaveData& SaveData)
 {
 	if (LevelStreamingName.IsEmpty()) return false;
 	
-	TArray<uint8> BinaryData;
 	const FString FilePath = LIBRARY::MakeTempFilePath(LevelStreamingName);
 	if (!FPaths::FileExists(FilePath)) return false;
-	if (!FFileHelper::LoadFileToArray(BinaryData, *FilePath)) return false;
 
-	FMemoryReader MemoryReader(BinaryData, true);
-	FObjectAndNameAsStringProxyArchive ReaderProxy(MemoryReader, /*bInLoadIfFindFails*/true);
-	FStreamingLevelSaveData::StaticStruct()->SerializeBin(ReaderProxy, &SaveData);
-	
-	return true;
+	return FStreamingLevelSaveCellFile::Load(FilePath, SaveData);
 }
 
-void UStreamingLevelSaveSubsystem::SaveLevelInternal(const ULevel* Level, bool bOnlyCollect, bool bAsync)
+FStreamingLevelSaveData* UStreamingLevelSaveSubsystem::CaptureLevelInternal(const ULevel* Level, bool bOnlyCollect)
 {
 	const auto StreamingLevelName = LIBRARY::GetLevelName(Level);
 	// Dont save level in ignore list.
@@ -277,241 +749,1398 @@ void UStreamingLevelSaveSubsystem::SaveLevelInternal(const ULevel* Level, bool b
 	{
 		if (Settings->IgnoreLevelNames.Find(StreamingLevelName) >= 0)
 		{
-			return;
+			return nullptr;
 		}
 	}
 	
-	if (const auto Found = GetOrAddTempCellSaveData(StreamingLevelName))
+	// Restoring may add temp datas, settle before taking the pointer.
+	SettlePendingRestores(Level);
+	if (const auto Ptr = GetOrAddTempCellSaveData(StreamingLevelName))
 	{
 		// Capture datas in game thread.
-		StorePersistentActors(Level, Found, bOnlyCollect);
-		StoreRuntimeActors(Level, Found, bOnlyCollect);
-		// Async save data to hard drive.
-		if (bAsync)
-		{
-			// Async
-			auto CachedData = *Found;
-			UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Level, CachedData, StreamingLevelName, bOnlyCollect]()
-			{
-				SaveTempData(StreamingLevelName, CachedData);
-				if (!bOnlyCollect)
-				{
-					AsyncTask(ENamedThreads::GameThread, [StreamingLevelName, Level, this]()
-					{
-						TempSaveDatas.Remove(StreamingLevelName);
-					});
-				}
-			});
-		}
-		else
-		{
-			// Sync
-			SaveTempData(StreamingLevelName, *Found);
-			if (!bOnlyCollect)
-			{
-				TempSaveDatas.Remove(StreamingLevelName);
-			}
-		}
+		StorePersistentActors(Level, Ptr, bOnlyCollect);
+		StoreRuntimeActors(Level, Ptr, bOnlyCollect);
 	}
-}
-
-void UStreamingLevelSaveSubsystem::LoadLevelInternal(const ULevel* Level)
-{
-	const auto StreamingLevelName = LIBRARY::GetLevelName(Level);
-
-	// Write to temp data. (No more async)
-	const auto Ptr = GetOrAddTempCellSaveData(LIBRARY::GetLevelName(Level));
-	LoadTempData(StreamingLevelName, *Ptr);
-	const auto LoadedData = *Ptr;
 
-	if (IsValid(Level))
+	// Destroying runtime actors may have added temp datas, find again.
+	const auto Found = FindTempData(StreamingLevelName);
+	if (Found)
 	{
-		FStreamingLevelSaveData GameLoadedData = LoadedData;
-		RestorePersistentActors(Level, &GameLoadedData);
-		RestoreRuntimeActors(&GameLoadedData);
+		// Stable order, same state gives same bytes.
+		Found->SaveDatas.KeySort(TLess<FGuid>());
+		Found->DestroyedActors.Sort();
 	}
+	return Found;
 }
 
-void UStreamingLevelSaveSubsystem::StoreObjectUnsafe(UObject* Object, FInstancedStruct& SaveData)
+void UStreamingLevelSaveSubsystem::SaveLevelInternal(const ULevel* Level, bool bOnlyCollect, bool bAsync)
 {
-	SaveData = INTERFACE::Execute_GetSaveData(Object);
-}
+	const double StartTime = FPlatformTime::Seconds();
+	const auto Found = CaptureLevelInternal(Level, bOnlyCollect);
+	if (!Found)
+	{
+		return;
+	}
+	const auto StreamingLevelName = LIBRARY::GetLevelName(Level);
+	WriteLevelData(StreamingLevelName, Found, bOnlyCollect, bAsync, Level->IsPersistentLevel(),
+		bAsync ? GetCellDistanceSquared(Level->GetWorldPartitionRuntimeCell()) : UE_DOUBLE_BIG_NUMBER);
 
-void UStreamingLevelSaveSubsystem::RestoreObjectUnsafe(UObject* Object, const FInstancedStruct& SaveData)
-{
-	INTERFACE::Execute_LoadSaveData(Object, SaveData);
+	SessionRecorder.Record(EStreamingLevelSaveRecordEvent::SaveLevel, StreamingLevelName,
+		(bOnlyCollect ? EStreamingLevelSaveRecordFlags::OnlyCollect : EStreamingLevelSaveRecordFlags::None)
+		| (bAsync ? EStreamingLevelSaveRecordFlags::Async : EStreamingLevelSaveRecordFlags::None), StartTime);
 }
 
-void UStreamingLevelSaveSubsystem::StoreActorComponents(const AActor* Actor, TMap<FGuid, FInstancedStruct>& Mappings)
+void UStreamingLevelSaveSubsystem::WriteLevelData(const FString& StreamingLevelName, FStreamingLevelSaveData* Found,
+	bool bOnlyCollect, bool bAsync, bool bPersistentLevel, double DistanceSquared)
 {
-	TInlineComponentArray<UActorComponent*> Components;
-	Actor->GetComponents(Components);
-
-	for (const auto Itr : Components)
+	// Written data is newer than quick loaded one.
+	QuickLoadPendingCells.Remove(StreamingLevelName);
+	// Decode started before this write is stale. Scheduler runs async write after it, sync write must wait.
+	UE::Tasks::TTask<TSharedPtr<FStreamingLevelSaveData>> StaleDecode;
+	if (PendingDecodes.RemoveAndCopyValue(StreamingLevelName, StaleDecode) && !bAsync)
 	{
-		if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
-		{
-			FInstancedStruct SaveDataStruct;
-			StoreObjectUnsafe(Itr, SaveDataStruct);
-			Mappings.Add(Id, SaveDataStruct);
-		}
+		IOScheduler->Promote(StreamingLevelName, EStreamingLevelSaveIOPriority::UrgentRead);
+		StaleDecode.Wait();
+	}
+	
+	// Async save data to hard drive.
+	if (bAsync)
+	{
+		// Unloading level gives its data to the writer. Collecting level lends it, it is moved back once written.
+		const auto CachedData = MakeShared<FStreamingLevelSaveData>(MoveTemp(*Found));
+		TempSaveDatas.Remove(StreamingLevelName);
+		if (!bOnlyCollect && bPersistentLevel)
+		{
+			CachePersistentLevel(StreamingLevelName, CachedData);
+		}
+
+		// Scheduler keeps writes of the same level in order.
+		const auto WriteTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::UnloadWrite, StreamingLevelName,
+			[CachedData, StreamingLevelName, Snapshot = ActiveSaveSnapshot]()
+		{
+			if (Snapshot)
+			{
+				Snapshot->PreserveFile(StreamingLevelName);
+			}
+			SaveTempData(StreamingLevelName, *CachedData);
+		}, DistanceSquared);
+		PendingWrites.Add(StreamingLevelName, WriteTask);
+		if (bOnlyCollect)
+		{
+			LentTempDatas.Add(StreamingLevelName, { CachedData, WriteTask });
+		}
+	}
+	else
+	{
+		// Sync
+		if (const auto PendingWrite = PendingWrites.Find(StreamingLevelName))
+		{
+			IOScheduler->Promote(StreamingLevelName, EStreamingLevelSaveIOPriority::UrgentRead);
+			PendingWrite->Wait();
+		}
+		if (ActiveSaveSnapshot)
+		{
+			ActiveSaveSnapshot->PreserveFile(StreamingLevelName);
+		}
+		
+		SaveTempData(StreamingLevelName, *Found);
+		if (!bOnlyCollect)
+		{
+			TempSaveDatas.Remove(StreamingLevelName);
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::LoadLevelInternal(const ULevel* Level)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const auto StreamingLevelName = LIBRARY::GetLevelName(Level);
+
+	// Write to temp data.
+	const auto Ptr = GetOrAddTempCellSaveData(StreamingLevelName);
+	if (!Ptr)
+	{
+		return;
+	}
+	ReadLevelData(StreamingLevelName, *Ptr);
+
+	if (IsValid(Level))
+	{
+		// Restoring may add temp datas and move the map, restore from a moved out data.
+		FStreamingLevelSaveData LoadedData = MoveTemp(*Ptr);
+		RestorePersistentActors(Level, &LoadedData);
+		RestoreRuntimeActors(&LoadedData);
+		// Records are live or dehydrated actors now.
+		LoadedData.RuntimeActorsSaveDatas.Empty();
+
+		// Move back, keep destroyed actors recorded while restoring.
+		if (const auto Found = GetOrAddTempCellSaveData(StreamingLevelName))
+		{
+			for (const auto& Id : Found->DestroyedActors)
+			{
+				LoadedData.DestroyedActors.AddUnique(Id);
+			}
+			LoadedData.DehydratedRuntimeActors.Append(MoveTemp(Found->DehydratedRuntimeActors));
+			*Found = MoveTemp(LoadedData);
+		}
+	}
+
+	SessionRecorder.Record(EStreamingLevelSaveRecordEvent::LoadLevel, StreamingLevelName, EStreamingLevelSaveRecordFlags::None, StartTime);
+}
+
+void UStreamingLevelSaveSubsystem::ReadLevelData(const FString& StreamingLevelName, FStreamingLevelSaveData& OutData)
+{
+	// Already loaded when level finished streaming, or kept in memory since map travel.
+	if (PreloadedLevelNames.Remove(StreamingLevelName) == 0 && !TakeCachedPersistentLevel(StreamingLevelName, OutData))
+	{
+		FinishDecodeCell(StreamingLevelName, OutData);
+	}
+}
+
+void UStreamingLevelSaveSubsystem::ReplayBeginDecode(const FString& LevelStreamingName)
+{
+	BeginDecodeCell(LevelStreamingName);
+}
+
+void UStreamingLevelSaveSubsystem::ReplaySaveLevel(const FString& LevelStreamingName, const FStreamingLevelSaveData& SaveData,
+	bool bOnlyCollect, bool bAsync)
+{
+	if (const auto Ptr = GetOrAddTempCellSaveData(LevelStreamingName))
+	{
+		*Ptr = SaveData;
+		WriteLevelData(LevelStreamingName, Ptr, bOnlyCollect, bAsync, false, UE_DOUBLE_BIG_NUMBER);
+	}
+}
+
+void UStreamingLevelSaveSubsystem::ReplayLoadLevel(const FString& LevelStreamingName)
+{
+	if (const auto Ptr = GetOrAddTempCellSaveData(LevelStreamingName))
+	{
+		ReadLevelData(LevelStreamingName, *Ptr);
+	}
+}
+
+void UStreamingLevelSaveSubsystem::ReplayFlush()
+{
+	WaitForPendingWrites();
+}
+
+void UStreamingLevelSaveSubsystem::CachePersistentLevel(const FString& LevelStreamingName, const TSharedPtr<FStreamingLevelSaveData>& SaveData)
+{
+	const auto MaxCached = GetDefault<UStreamingLevelSaveSettings>()->MaxCachedPersistentLevels;
+	if (MaxCached <= 0)
+	{
+		return;
+	}
+
+	PersistentLevelCache.Add(LevelStreamingName, SaveData);
+	PersistentLevelCacheOrder.Remove(LevelStreamingName);
+	PersistentLevelCacheOrder.Add(LevelStreamingName);
+
+	// Evicting only drops memory, temp file is written behind anyway.
+	while (PersistentLevelCacheOrder.Num() > MaxCached)
+	{
+		PersistentLevelCache.Remove(PersistentLevelCacheOrder[0]);
+		PersistentLevelCacheOrder.RemoveAt(0);
+	}
+}
+
+bool UStreamingLevelSaveSubsystem::TakeCachedPersistentLevel(const FString& LevelStreamingName, FStreamingLevelSaveData& OutData)
+{
+	TSharedPtr<FStreamingLevelSaveData> Cached;
+	if (!PersistentLevelCache.RemoveAndCopyValue(LevelStreamingName, Cached))
+	{
+		return false;
+	}
+	PersistentLevelCacheOrder.Remove(LevelStreamingName);
+
+	// Writer reads the same data, it is usually done long before player comes back.
+	if (const auto PendingWrite = PendingWrites.Find(LevelStreamingName))
+	{
+		IOScheduler->Promote(LevelStreamingName, EStreamingLevelSaveIOPriority::UrgentRead);
+		PendingWrite->Wait();
+	}
+
+	INC_DWORD_STAT(STAT_StreamingLevelSave_PersistentLevelCacheHits);
+	OutData = MoveTemp(*Cached);
+	return true;
+}
+
+void UStreamingLevelSaveSubsystem::BeginDecodeCell(const FString& LevelStreamingName, double DistanceSquared)
+{
+	if (LevelStreamingName.IsEmpty())
+	{
+		return;
+	}
+	
+	// Quick loaded level decodes from memory, not ordered with its write behind. Cell stays pending until decode is finished.
+	if (QuickLoadPendingCells.Contains(LevelStreamingName))
+	{
+		PendingDecodes.Add(LevelStreamingName, UE::Tasks::Launch(UE_SOURCE_LOCATION,
+			[Snapshot = QuickLoadSnapshot, LevelStreamingName]() -> TSharedPtr<FStreamingLevelSaveData>
+		{
+			const auto Data = MakeShared<FStreamingLevelSaveData>();
+			if (!FStreamingLevelSaveCellFile::LoadFromMemory(Snapshot->Cells[LevelStreamingName], LevelStreamingName, *Data))
+			{
+				return nullptr;
+			}
+			
+			INC_DWORD_STAT(STAT_StreamingLevelSave_WorkerDecodes);
+			return Data;
+		}));
+		return;
+	}
+	
+	// Scheduler runs it after pending writes of the level, and after slot is copied while loading.
+	TArray<UE::Tasks::FTask, TInlineAllocator<1>> Prerequisites;
+	if (LoadCopyTask.IsValid())
+	{
+		Prerequisites.Add(LoadCopyTask);
+	}
+	const auto Result = MakeShared<TSharedPtr<FStreamingLevelSaveData>>();
+	const auto ReadTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::PrefetchRead, LevelStreamingName,
+		[LevelStreamingName, Result]()
+	{
+		const auto Data = MakeShared<FStreamingLevelSaveData>();
+		if (LoadTempData(LevelStreamingName, *Data))
+		{
+			INC_DWORD_STAT(STAT_StreamingLevelSave_WorkerDecodes);
+			*Result = Data;
+		}
+	}, DistanceSquared, Prerequisites);
+
+	PendingDecodes.Add(LevelStreamingName, UE::Tasks::Launch(UE_SOURCE_LOCATION, [Result]()
+	{
+		return *Result;
+	}, ReadTask));
+}
+
+bool UStreamingLevelSaveSubsystem::FinishDecodeCell(const FString& LevelStreamingName, FStreamingLevelSaveData& OutData)
+{
+	// Game thread is waiting now, run this level's queued jobs first.
+	IOScheduler->Promote(LevelStreamingName, EStreamingLevelSaveIOPriority::UrgentRead);
+	const bool bQuickLoaded = QuickLoadPendingCells.Remove(LevelStreamingName) > 0;
+	
+	UE::Tasks::TTask<TSharedPtr<FStreamingLevelSaveData>> Task;
+	if (PendingDecodes.RemoveAndCopyValue(LevelStreamingName, Task))
+	{
+		SCOPE_CYCLE_COUNTER(STAT_StreamingLevelSave_WaitDecodeCell);
+		Task.Wait();
+		if (const auto& Result = Task.GetResult())
+		{
+			OutData = MoveTemp(*Result);
+			return true;
+		}
+		// Worker could not load types of some records, or read failed. Decode again on game thread.
+		OutData = FStreamingLevelSaveData();
+	}
+
+	// Not started or failed on worker, decode on game thread.
+	if (bQuickLoaded)
+	{
+		return FStreamingLevelSaveCellFile::LoadFromMemory(QuickLoadSnapshot->Cells[LevelStreamingName], LevelStreamingName, OutData);
+	}
+	
+	if (const auto PendingWrite = PendingWrites.Find(LevelStreamingName))
+	{
+		PendingWrite->Wait();
+	}
+	if (LoadCopyTask.IsValid())
+	{
+		LoadCopyTask.Wait();
+	}
+	
+	return LoadTempData(LevelStreamingName, OutData);
+}
+
+double UStreamingLevelSaveSubsystem::GetCellDistanceSquared(const UWorldPartitionRuntimeCell* Cell) const
+{
+	if (!Cell)
+	{
+		return UE_DOUBLE_BIG_NUMBER;
+	}
+
+	TArray<FVector> SourceLocations;
+	GatherStreamingSourceLocations(SourceLocations);
+	return GetClosestSourceDistanceSquared(SourceLocations, Cell->GetCellBounds().GetCenter());
+}
+
+void UStreamingLevelSaveSubsystem::WaitForPendingWrites()
+{
+	for (const auto& Pair : PendingWrites)
+	{
+		Pair.Value.Wait();
+	}
+	
+	PendingWrites.Empty();
+}
+
+void UStreamingLevelSaveSubsystem::StoreObjectUnsafe(UObject* Object, FInstancedStruct& SaveData)
+{
+	SaveData = INTERFACE::Execute_GetSaveData(Object);
+	INC_DWORD_STAT(STAT_StreamingLevelSave_StoredObjects);
+}
+
+void UStreamingLevelSaveSubsystem::StoreObjectIfDirty(UObject* Object, FInstancedStruct& SaveData)
+{
+	if (SaveData.IsValid() && !INTERFACE::Execute_IsSaveDataDirty(Object))
+	{
+		INC_DWORD_STAT(STAT_StreamingLevelSave_UnchangedObjects);
+		return;
+	}
+
+	StoreObjectUnsafe(Object, SaveData);
+}
+
+void UStreamingLevelSaveSubsystem::RestoreObjectUnsafe(UObject* Object, const FInstancedStruct& SaveData)
+{
+	INTERFACE::Execute_LoadSaveData(Object, SaveData);
+}
+
+void UStreamingLevelSaveSubsystem::StoreActorComponents(const AActor* Actor, TMap<FGuid, FInstancedStruct>& Mappings)
+{
+	TInlineComponentArray<UActorComponent*> Components;
+	Actor->GetComponents(Components);
+
+	for (const auto Itr : Components)
+	{
+		if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		{
+			StoreObjectIfDirty(Itr, Mappings.FindOrAdd(Id));
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::RestoreActorComponents(const AActor* Actor,
+	const TMap<FGuid, FInstancedStruct>& Mappings, TSet<const UActorComponent*>* RestoredComponents)
+{
+	TInlineComponentArray<UActorComponent*> Components;
+	Actor->GetComponents(Components);
+
+	for (const auto Itr : Components)
+	{
+		if (RestoredComponents && RestoredComponents->Contains(Itr)) continue;
+		
+		if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		{
+			if (const auto FoundData = Mappings.Find(Id))
+			{
+				RestoreObjectUnsafe(Itr, *FoundData);
+				if (RestoredComponents)
+				{
+					RestoredComponents->Add(Itr);
+				}
+			}
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::FilterDestroyedActors(ULevel* Level)
+{
+	const auto StreamingLevelName = LIBRARY::GetLevelName(Level);
+	if (GetDefault<UStreamingLevelSaveSettings>()->IgnoreLevelNames.Contains(StreamingLevelName))
+	{
+		return;
+	}
+	
+	// Filter once decode is done. Level added to world before destroys recorded actors while restoring.
+	if (const auto PendingDecode = PendingDecodes.Find(StreamingLevelName); PendingDecode && !PendingDecode->IsCompleted())
+	{
+		PendingFilterLevels.AddUnique(Level);
+		return;
+	}
+	
+	const auto Ptr = GetOrAddTempCellSaveData(StreamingLevelName);
+	if (!Ptr)
+	{
+		return;
+	}
+	
+	FinishDecodeCell(StreamingLevelName, *Ptr);
+	PreloadedLevelNames.Add(StreamingLevelName);
+
+	// Build layout before anything is destroyed.
+	const auto Layout = FindOrBuildDenseLayout(Level);
+	const bool bDense = Layout && Ptr->Dense.IsValid() && Ptr->Dense.LayoutHash == Layout->Hash;
+	if (Ptr->DestroyedActors.Num() == 0 && !bDense)
+	{
+		return;
+	}
+
+	// Copy ids, destroy callbacks may add temp datas.
+	const TSet<FGuid> DestroyedIds(Ptr->DestroyedActors);
+	FStreamingLevelSaveDenseData DenseData;
+	if (bDense)
+	{
+		DenseData.DestroyedBits = Ptr->Dense.DestroyedBits;
+	}
+	const auto Actors = Level->Actors;
+	for (int32 ActorIndex = 0; ActorIndex < Actors.Num(); ++ActorIndex)
+	{
+		const auto Itr = Actors[ActorIndex];
+		if (!IsValid(Itr)) continue;
+		if (Itr->HasAnyFlags(RF_ClassDefaultObject)) continue;
+
+		// Components are not registered and BeginPlay is not called yet.
+		if (const int32 DenseIndex = bDense ? GetDenseIndex(*Layout, ActorIndex, Itr) : INDEX_NONE; DenseIndex != INDEX_NONE)
+		{
+			if (DenseData.IsDestroyed(DenseIndex))
+			{
+				Itr->Destroy(true);
+			}
+		}
+		else if (DestroyedIds.Num() > 0)
+		{
+			if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id) && DestroyedIds.Contains(Id))
+			{
+				Itr->Destroy(true);
+			}
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::TickPendingFilters()
+{
+	for (int32 Index = PendingFilterLevels.Num() - 1; Index >= 0; --Index)
+	{
+		const auto Level = PendingFilterLevels[Index].Get();
+		if (!Level || VisibleStreamingLevels.Contains(Level))
+		{
+			PendingFilterLevels.RemoveAtSwap(Index);
+			continue;
+		}
+		
+		if (const auto PendingDecode = PendingDecodes.Find(LIBRARY::GetLevelName(Level)); !PendingDecode || PendingDecode->IsCompleted())
+		{
+			PendingFilterLevels.RemoveAtSwap(Index);
+			FilterDestroyedActors(Level);
+		}
+	}
+}
+
+const FStreamingLevelSaveDenseLayout* UStreamingLevelSaveSubsystem::FindOrBuildDenseLayout(const ULevel* Level)
+{
+	if (!GetDefault<UStreamingLevelSaveSettings>()->bUseDenseCellLayout || !Level)
+	{
+		return nullptr;
+	}
+
+	const auto LevelName = LIBRARY::GetLevelName(Level);
+	if (!DenseLayouts.Contains(LevelName))
+	{
+		// Cooked level actors are a fixed set in a fixed order.
+		FStreamingLevelSaveDenseLayout& Layout = DenseLayouts.Add(LevelName);
+		Layout.ActorNames.SetNum(Level->Actors.Num());
+		Layout.DenseIndices.Init(INDEX_NONE, Level->Actors.Num());
+		for (int32 ActorIndex = 0; ActorIndex < Level->Actors.Num(); ++ActorIndex)
+		{
+			const auto Actor = Level->Actors[ActorIndex];
+			if (!IsValid(Actor) || Actor->HasAnyFlags(RF_ClassDefaultObject)) continue;
+			if (!LIBRARY::IsRuntimeObject(Actor))
+			{
+				Layout.ActorNames[ActorIndex] = Actor->GetFName();
+				if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Actor, Id) && !Layout.DenseIndexByGuid.Contains(Id))
+				{
+					Layout.DenseIndices[ActorIndex] = Layout.Guids.Add(Id);
+					Layout.DenseIndexByGuid.Add(Id, Layout.DenseIndices[ActorIndex]);
+				}
+			}
+		}
+		
+		Layout.Hash = FMath::Max(1u, FCrc::MemCrc32(Layout.Guids.GetData(), Layout.Guids.Num() * sizeof(FGuid)));
+	}
+
+	return FindDenseLayout(Level);
+}
+
+const FStreamingLevelSaveDenseLayout* UStreamingLevelSaveSubsystem::FindDenseLayout(const ULevel* Level) const
+{
+	if (!GetDefault<UStreamingLevelSaveSettings>()->bUseDenseCellLayout || !Level)
+	{
+		return nullptr;
+	}
+
+	const auto Found = DenseLayouts.Find(LIBRARY::GetLevelName(Level));
+	return Found && Found->Guids.Num() > 0 ? Found : nullptr;
+}
+
+int32 UStreamingLevelSaveSubsystem::GetDenseIndex(const FStreamingLevelSaveDenseLayout& Layout, int32 ActorIndex, const AActor* Actor)
+{
+	// Sequential access, no guid needed.
+	if (Layout.ActorNames.IsValidIndex(ActorIndex) && Layout.ActorNames[ActorIndex] == Actor->GetFName())
+	{
+		return Layout.DenseIndices[ActorIndex];
+	}
+
+	// Actors were reordered, fallback to guid.
+	if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Actor, Id))
+	{
+		if (const auto Found = Layout.DenseIndexByGuid.Find(Id))
+		{
+			return *Found;
+		}
+	}
+	
+	return INDEX_NONE;
+}
+
+void UStreamingLevelSaveSubsystem::ExpandDenseData(FStreamingLevelSaveData& SaveData)
+{
+	auto& Dense = SaveData.Dense;
+	if (Dense.IsValid())
+	{
+		for (int32 DenseIndex = 0; DenseIndex < Dense.Guids.Num(); ++DenseIndex)
+		{
+			if (Dense.IsDestroyed(DenseIndex))
+			{
+				SaveData.DestroyedActors.AddUnique(Dense.Guids[DenseIndex]);
+			}
+			else if (Dense.SaveDatas[DenseIndex].IsValid())
+			{
+				SaveData.SaveDatas.Add(Dense.Guids[DenseIndex], MoveTemp(Dense.SaveDatas[DenseIndex]));
+			}
+		}
+	}
+	
+	Dense = FStreamingLevelSaveDenseData();
+}
+
+void UStreamingLevelSaveSubsystem::GatherDestroyedActors(const FStreamingLevelSaveData& SaveData, TSet<FGuid>& OutIds)
+{
+	OutIds.Append(SaveData.DestroyedActors);
+	const auto& Dense = SaveData.Dense;
+	for (int32 DenseIndex = 0; DenseIndex < Dense.Guids.Num(); ++DenseIndex)
+	{
+		if (Dense.IsDestroyed(DenseIndex))
+		{
+			OutIds.Add(Dense.Guids[DenseIndex]);
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::StorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData, bool bCollectOnly)
+{
+	if (!SaveData || !Level)
+	{
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(StreamingLevelSave);
+	
+	// Switch data to current layout, guid mappings only keep unknown objects.
+	const auto Layout = FindDenseLayout(Level);
+	if (Layout && SaveData->Dense.LayoutHash != Layout->Hash)
+	{
+		ExpandDenseData(*SaveData);
+		SaveData->Dense.Init(Layout->Hash, Layout->Guids);
+		// Carry datas over, actors with deferred restore are not stored again.
+		for (int32 DenseIndex = 0; DenseIndex < Layout->Guids.Num(); ++DenseIndex)
+		{
+			SaveData->SaveDatas.RemoveAndCopyValue(Layout->Guids[DenseIndex], SaveData->Dense.SaveDatas[DenseIndex]);
+		}
+	}
+	else if (!Layout)
+	{
+		ExpandDenseData(*SaveData);
+	}
+
+	TBitArray<> StoredDenseIndices(false, Layout ? Layout->Guids.Num() : 0);
+	SaveData->SaveDatas.Reserve(Level->Actors.Num());
+	for (int32 ActorIndex = 0; ActorIndex < Level->Actors.Num(); ++ActorIndex)
+	{
+		const auto Itr = Level->Actors[ActorIndex];
+		if (!IsValid(Itr)) continue;
+		if (Itr->HasAnyFlags(RF_ClassDefaultObject)) continue;
+		if (Itr->IsActorBeingDestroyed()) continue;
+
+		// Unchanged since deferred, loaded datas of actor and its components are still as restored.
+		const bool bPendingRestore = bCollectOnly ? PendingRestores.Contains(Itr.Get()) : PendingRestores.Remove(Itr.Get()) > 0;
+		if (const int32 DenseIndex = Layout ? GetDenseIndex(*Layout, ActorIndex, Itr) : INDEX_NONE; DenseIndex != INDEX_NONE)
+		{
+			if (!bCollectOnly)
+			{
+				TrackedActors.Remove(Itr.Get());
+			}
+			if (!bPendingRestore)
+			{
+				StoreObjectIfDirty(Itr, SaveData->Dense.SaveDatas[DenseIndex]);
+			}
+			StoredDenseIndices[DenseIndex] = true;
+		}
+		else if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		{
+			if (!bCollectOnly)
+			{
+				TrackedActors.Remove(Itr.Get());
+			}
+			if (!bPendingRestore)
+			{
+				StoreObjectIfDirty(Itr, SaveData->SaveDatas.FindOrAdd(Id));
+			}
+		}
+		if (!bPendingRestore)
+		{
+			StoreActorComponents(Itr, SaveData->SaveDatas);
+		}
+	}
+
+	// Layout actors which are gone were destroyed, destroyed state is kept in bits.
+	if (Layout)
+	{
+		for (int32 DenseIndex = 0; DenseIndex < Layout->Guids.Num(); ++DenseIndex)
+		{
+			if (!StoredDenseIndices[DenseIndex])
+			{
+				SaveData->Dense.SetDestroyed(DenseIndex);
+				SaveData->Dense.SaveDatas[DenseIndex].Reset();
+			}
+		}
+		
+		SaveData->DestroyedActors.RemoveAll([Layout](const FGuid& Id)
+		{
+			return Layout->DenseIndexByGuid.Contains(Id);
+		});
+	}
+}
+
+void UStreamingLevelSaveSubsystem::RestorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData)
+{
+	if (!SaveData || !Level)
+	{
+		return;
+	}
+	
+	// Saved with another layout, use guid mappings.
+	const auto Layout = FindOrBuildDenseLayout(Level);
+	if (SaveData->Dense.IsValid() && (!Layout || Layout->Hash != SaveData->Dense.LayoutHash))
+	{
+		ExpandDenseData(*SaveData);
+	}
+	const bool bDense = Layout && SaveData->Dense.IsValid();
+	const bool bLazy = GetDefault<UStreamingLevelSaveSettings>()->bLazyRestorePersistentActors;
+	const auto LevelName = LIBRARY::GetLevelName(Level);
+	BindActorDestroyedHandler(Level->OwningWorld);
+	
+	for (int32 ActorIndex = 0; ActorIndex < Level->Actors.Num(); ++ActorIndex)
+	{
+		const auto Itr = Level->Actors[ActorIndex];
+		if (!IsValid(Itr)) continue;
+		if (Itr->HasAnyFlags(RF_ClassDefaultObject)) continue;
+		if (Itr->IsActorBeingDestroyed()) continue;
+		
+		FGuid Id;
+		if (const int32 DenseIndex = bDense ? GetDenseIndex(*Layout, ActorIndex, Itr) : INDEX_NONE; DenseIndex != INDEX_NONE)
+		{
+			// Sequential access by dense index.
+			if (SaveData->Dense.IsDestroyed(DenseIndex))
+			{
+				Itr->Destroy(true);
+				continue;
+			}
+			
+			if (bLazy)
+			{
+				PendingRestores.Add(Itr.Get(), { Itr.Get(), LevelName, Layout->Guids[DenseIndex], !INTERFACE::Execute_IsSaveDataDirty(Itr) });
+				TrackedActors.Add(Itr.Get());
+				continue;
+			}
+			
+			if (const auto& FoundData = SaveData->Dense.SaveDatas[DenseIndex]; FoundData.IsValid())
+			{
+				RestoreObjectUnsafe(Itr, FoundData);
+			}
+			else
+			{
+				INTERFACE::Execute_PostLoadSaveData(Itr);
+			}
+			
+			TrackedActors.Add(Itr.Get());
+		}
+		else if (LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		{
+			// Destroy state.
+			if (SaveData->DestroyedActors.Find(Id) >= 0)
+			{
+				Itr->Destroy(true);
+			}
+			else
+			{
+				if (bLazy)
+				{
+					PendingRestores.Add(Itr.Get(), { Itr.Get(), LevelName, Id, !INTERFACE::Execute_IsSaveDataDirty(Itr) });
+					TrackedActors.Add(Itr.Get());
+					continue;
+				}
+				
+				if (const auto FoundData = SaveData->SaveDatas.Find(Id))
+				{
+					RestoreObjectUnsafe(Itr, *FoundData);
+				}
+				else
+				{
+					// If not destroyed we execute post load save data.
+					INTERFACE::Execute_PostLoadSaveData(Itr);
+				}
+				
+				TrackedActors.Add(Itr.Get());
+			}
+		}
+		RestoreActorComponents(Itr, SaveData->SaveDatas);
+	}
+}
+
+void UStreamingLevelSaveSubsystem::BindActorDestroyedHandler(UWorld* World)
+{
+	if (!World || (ActorDestroyedWorld == World && ActorDestroyedHandle.IsValid()))
+	{
+		return;
+	}
+
+	// Actors of previous world are gone.
+	if (ActorDestroyedWorld != World)
+	{
+		TrackedActors.Empty();
+	}
+	UnbindActorDestroyedHandler();
+	ActorDestroyedWorld = World;
+	ActorDestroyedHandle = World->AddOnActorDestroyedHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &ThisClass::OnLevelActorDestroyed));
+}
+
+void UStreamingLevelSaveSubsystem::UnbindActorDestroyedHandler()
+{
+	if (const auto World = ActorDestroyedWorld.Get())
+	{
+		World->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+	}
+	
+	ActorDestroyedHandle.Reset();
+}
+
+void UStreamingLevelSaveSubsystem::StoreRuntimeActors(const ULevel* InLevel,
+	FStreamingLevelSaveData* SaveData, bool bCollectOnly)
+{
+	// Runtime actors are captured again on every store, dehydrated ones still belong to this cell.
+	SaveData->RuntimeActorsSaveDatas.Reset();
+	if (bCollectOnly)
+	{
+		SaveData->RuntimeActorsSaveDatas.Append(SaveData->DehydratedRuntimeActors);
+	}
+	else
+	{
+		SaveData->RuntimeActorsSaveDatas = MoveTemp(SaveData->DehydratedRuntimeActors);
+		SaveData->DehydratedRuntimeActors.Reset();
+	}
+	
+	TArray<UStreamingLevelSaveComponent*> Components;
+	for (const auto Itr : RuntimeActorComponents)
+	{
+		// Store runtime actor
+		const auto OwnerActor = Itr->GetOwner();
+		const auto Cell = InLevel->GetWorldPartitionRuntimeCell();
+		if (Cell && Cell->GetCellBounds().IsInsideXY(OwnerActor->GetActorLocation()))
+		{
+			if (Itr->bSave)
+			{
+				StoreRuntimeActor(Itr->GetOwner(), SaveData->RuntimeActorsSaveDatas.AddDefaulted_GetRef());
+				Components.Add(Itr);
+			}
+			else
+			{
+				// Additional Feature : Destroy runtime actor if not save that.
+				Components.Add(Itr);
+			}
+		}
+	}
+	// Remove actors.
+	if (!bCollectOnly)
+	{
+		for (const auto Itr : Components)
+		{
+			ReleaseRuntimeActor(Itr, true);
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::StoreRuntimeActor(AActor* Actor,
+	FStreamingLevelSaveRuntimeData& RuntimeActorData)
+{
+	FInstancedStruct SaveDataStruct;
+	StoreObjectUnsafe(Actor, SaveDataStruct);
+	RuntimeActorData.AdditionalData = MoveTemp(SaveDataStruct);
+	RuntimeActorData.ActorClass = Actor->GetClass();
+	RuntimeActorData.ActorTransform = Actor->GetActorTransform();
+	RuntimeActorData.ActorVelocity = Actor->GetVelocity();
+	StoreActorComponents(Actor, RuntimeActorData.Components);
+}
+
+void UStreamingLevelSaveSubsystem::RestoreRuntimeActors(FStreamingLevelSaveData* SaveData)
+{
+	// Records far away from every streaming source stay dehydrated, no need to spawn them.
+	TArray<FVector> SourceLocations;
+	double DehydrationDistSq = UE_DOUBLE_BIG_NUMBER;
+	if (const auto Settings = GetDefault<UStreamingLevelSaveSettings>(); Settings->bEnableRuntimeActorDehydration)
+	{
+		GatherStreamingSourceLocations(SourceLocations);
+		DehydrationDistSq = FMath::Square(static_cast<double>(Settings->DehydrationDistance));
+	}
+	
+	// Spawn all actors deferred first, then finish them in one batch.
+	TArray<FDeferredRuntimeActor> DeferredActors;
+	DeferredActors.Reserve(SaveData->RuntimeActorsSaveDatas.Num());
+	for (auto& Itr : SaveData->RuntimeActorsSaveDatas)
+	{
+		if (SourceLocations.Num() > 0 &&
+			GetClosestSourceDistanceSquared(SourceLocations, Itr.ActorTransform.GetLocation()) > DehydrationDistSq)
+		{
+			SaveData->DehydratedRuntimeActors.Add(MoveTemp(Itr));
+			continue;
+		}
+
+		if (FDeferredRuntimeActor Deferred; BeginRestoreRuntimeActor(Itr, Deferred))
+		{
+			DeferredActors.Add(MoveTemp(Deferred));
+		}
+	}
+
+	for (auto& Itr : DeferredActors)
+	{
+		FinishRestoreRuntimeActor(Itr);
+	}
+}
+
+AActor* UStreamingLevelSaveSubsystem::RestoreRuntimeActor(const FStreamingLevelSaveRuntimeData& RuntimeActorData)
+{
+	FDeferredRuntimeActor Deferred;
+	if (!BeginRestoreRuntimeActor(RuntimeActorData, Deferred))
+	{
+		return nullptr;
+	}
+	
+	FinishRestoreRuntimeActor(Deferred);
+	return Deferred.Actor;
+}
+
+bool UStreamingLevelSaveSubsystem::BeginRestoreRuntimeActor(const FStreamingLevelSaveRuntimeData& RuntimeActorData,
+	FDeferredRuntimeActor& OutDeferred)
+{
+	const auto ActorClass = RuntimeActorData.ActorClass.LoadSynchronous();
+	if (!ActorClass)
+	{
+		return false;
+	}
+
+	OutDeferred.Data = &RuntimeActorData;
+	OutDeferred.bFromPool = TakePooledRuntimeActor(ActorClass, OutDeferred.Pooled);
+	if (OutDeferred.bFromPool)
+	{
+		OutDeferred.Actor = OutDeferred.Pooled.Actor;
+		OutDeferred.Actor->SetActorTransform(RuntimeActorData.ActorTransform, false, nullptr, ETeleportType::ResetPhysics);
+	}
+	else
+	{
+		OutDeferred.Actor = GetWorld()->SpawnActorDeferred<AActor>(ActorClass, RuntimeActorData.ActorTransform,
+			nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	}
+
+	if (!OutDeferred.Actor)
+	{
+		return false;
+	}
+
+	// Restore before BeginPlay, components created by construction are restored when finishing.
+	RestoreObjectUnsafe(OutDeferred.Actor, RuntimeActorData.AdditionalData);
+	RestoreActorComponents(OutDeferred.Actor, RuntimeActorData.Components, &OutDeferred.RestoredComponents);
+	return true;
+}
+
+void UStreamingLevelSaveSubsystem::FinishRestoreRuntimeActor(FDeferredRuntimeActor& Deferred)
+{
+	const auto Actor = Deferred.Actor;
+	if (!IsValid(Actor))
+	{
+		return;
+	}
+	
+	if (Deferred.bFromPool)
+	{
+		Actor->SetActorHiddenInGame(Deferred.Pooled.bHidden);
+		Actor->SetActorEnableCollision(Deferred.Pooled.bCollisionEnabled);
+		Actor->SetActorTickEnabled(Deferred.Pooled.bTickEnabled);
+	}
+	else
+	{
+		Actor->FinishSpawning(Deferred.Data->ActorTransform);
+		RestoreActorComponents(Actor, Deferred.Data->Components, &Deferred.RestoredComponents);
+	}
+	
+	if (Actor->GetRootComponent())
+	{
+		Actor->GetRootComponent()->ComponentVelocity = Deferred.Data->ActorVelocity;
+	}
+
+	if (Deferred.bFromPool)
+	{
+		if (const auto Comp = Actor->FindComponentByClass<UStreamingLevelSaveComponent>())
+		{
+			RuntimeActorComponents.Add(Comp);
+			Comp->OnTakenFromPool.Broadcast();
+		}
+	}
+}
+
+void UStreamingLevelSaveSubsystem::ReleaseRuntimeActor(UStreamingLevelSaveComponent* Component, bool bAllowPool)
+{
+	const auto Actor = Component->GetOwner();
+	const int32 MaxPooled = GetDefault<UStreamingLevelSaveSettings>()->MaxPooledRuntimeActorsPerClass;
+	if (bAllowPool && Component->bAllowPooling && MaxPooled > 0)
+	{
+		auto& Pool = RuntimeActorPools.FindOrAdd(Actor->GetClass());
+		if (Pool.Actors.Num() < MaxPooled)
+		{
+			// Keep state to reactivate with, actor may have been hidden or without collision on purpose.
+			auto& Pooled = Pool.Actors.AddDefaulted_GetRef();
+			Pooled.Actor = Actor;
+			Pooled.bHidden = Actor->IsHidden();
+			Pooled.bCollisionEnabled = Actor->GetActorEnableCollision();
+			Pooled.bTickEnabled = Actor->IsActorTickEnabled();
+			
+			Actor->SetActorHiddenInGame(true);
+			Actor->SetActorEnableCollision(false);
+			Actor->SetActorTickEnabled(false);
+			if (const auto Primitive = Cast<UPrimitiveComponent>(Actor->GetRootComponent()))
+			{
+				Primitive->PutRigidBodyToSleep();
+			}
+			
+			// Pooled actors are not runtime actors of any cell anymore.
+			RuntimeActorComponents.Remove(Component);
+			Component->OnReturnedToPool.Broadcast();
+			return;
+		}
+	}
+
+	Actor->Destroy(true);
+}
+
+bool UStreamingLevelSaveSubsystem::TakePooledRuntimeActor(UClass* ActorClass, FStreamingLevelSavePooledActor& OutPooled)
+{
+	if (const auto Pool = RuntimeActorPools.Find(ActorClass))
+	{
+		while (Pool->Actors.Num() > 0)
+		{
+			OutPooled = Pool->Actors.Pop(EAllowShrinking::No);
+			if (IsValid(OutPooled.Actor) && !OutPooled.Actor->IsActorBeingDestroyed())
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void UStreamingLevelSaveSubsystem::ClearRuntimeActorPools()
+{
+	for (const auto& Pair : RuntimeActorPools)
+	{
+		for (const auto& Itr : Pair.Value.Actors)
+		{
+			if (IsValid(Itr.Actor))
+			{
+				Itr.Actor->Destroy(true);
+			}
+		}
+	}
+	
+	RuntimeActorPools.Empty();
+}
+
+void UStreamingLevelSaveSubsystem::TickRuntimeActorDehydration()
+{
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	if (!Settings->bEnableRuntimeActorDehydration || !SaveLoadSequence || SaveLoadSequence->bProgressing)
+	{
+		return;
+	}
+
+	TArray<FVector> SourceLocations;
+	GatherStreamingSourceLocations(SourceLocations);
+	if (SourceLocations.Num() == 0)
+	{
+		return;
+	}
+
+	// Dehydrate runtime actors which are far away from every streaming source.
+	const double DehydrationDistSq = FMath::Square(static_cast<double>(Settings->DehydrationDistance));
+	TArray<TPair<UStreamingLevelSaveComponent*, FString>> ToDehydrate;
+	for (const auto Itr : RuntimeActorComponents)
+	{
+		if (!IsValid(Itr) || !Itr->bSave || !Itr->bAllowDehydration) continue;
+		
+		const auto OwnerActor = Itr->GetOwner();
+		if (!IsValid(OwnerActor) || OwnerActor->IsActorBeingDestroyed()) continue;
+		if (GetClosestSourceDistanceSquared(SourceLocations, OwnerActor->GetActorLocation()) <= DehydrationDistSq) continue;
+		
+		// Only dehydrate inside cells which will be saved, otherwise the record would be lost. Skipped ones use no budget.
+		const auto LevelName = LIBRARY::GetLevelName(FindRuntimeActorLevel(OwnerActor));
+		if (LevelName.IsEmpty() || Settings->IgnoreLevelNames.Contains(LevelName)) continue;
+		
+		ToDehydrate.Emplace(Itr, LevelName);
+		if (ToDehydrate.Num() >= Settings->MaxDehydrationsPerFrame) break;
+	}
+
+	for (const auto& Itr : ToDehydrate)
+	{
+		if (const auto Found = GetOrAddTempCellSaveData(Itr.Value))
+		{
+			StoreRuntimeActor(Itr.Key->GetOwner(), Found->DehydratedRuntimeActors.AddDefaulted_GetRef());
+			ReleaseRuntimeActor(Itr.Key, true);
+		}
+	}
+
+	// Rehydrate records which are back in range, hysteresis by using smaller distance. Cells lent to their write wait for next frame.
+	const double RehydrationDistSq = FMath::Square(static_cast<double>(FMath::Min(Settings->RehydrationDistance, Settings->DehydrationDistance)));
+	TArray<FStreamingLevelSaveRuntimeData> ToRehydrate;
+	for (auto& Pair : TempSaveDatas)
+	{
+		auto& Records = Pair.Value.DehydratedRuntimeActors;
+		for (int32 Index = Records.Num() - 1; Index >= 0 && ToRehydrate.Num() < Settings->MaxRehydrationsPerFrame; --Index)
+		{
+			if (GetClosestSourceDistanceSquared(SourceLocations, Records[Index].ActorTransform.GetLocation()) <= RehydrationDistSq)
+			{
+				ToRehydrate.Add(MoveTemp(Records[Index]));
+				Records.RemoveAtSwap(Index);
+			}
+		}
+	}
+
+	// Spawn outside of map iteration, spawned actors may touch temp datas.
+	for (const auto& Itr : ToRehydrate)
+	{
+		RestoreRuntimeActor(Itr);
 	}
 }
 
-void UStreamingLevelSaveSubsystem::RestoreActorComponents(const AActor* Actor,
-	const TMap<FGuid, FInstancedStruct>& Mappings)
+const ULevel* UStreamingLevelSaveSubsystem::FindRuntimeActorLevel(const AActor* Actor) const
 {
-	TInlineComponentArray<UActorComponent*> Components;
-	Actor->GetComponents(Components);
-
-	for (const auto Itr : Components)
+	for (const auto Level : VisibleStreamingLevels)
 	{
-		if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		if (const auto Cell = Level->GetWorldPartitionRuntimeCell())
 		{
-			if (const auto FoundData = Mappings.Find(Id))
+			if (Cell->GetCellBounds().IsInsideXY(Actor->GetActorLocation()))
 			{
-				RestoreObjectUnsafe(Itr, *FoundData);
+				return Level;
 			}
 		}
 	}
+
+	return nullptr;
 }
 
-void UStreamingLevelSaveSubsystem::StorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData, bool bCollectOnly) const
+void UStreamingLevelSaveSubsystem::GatherStreamingSourceLocations(TArray<FVector>& OutLocations) const
 {
-	if (!SaveData || !Level)
+	const auto World = GetWorld();
+	if (!World)
 	{
 		return;
 	}
 
-	for (auto Itr : Level->Actors)
+	if (const auto WorldPartitionSubsystem = World->GetSubsystem<UWorldPartitionSubsystem>())
 	{
-		if (!IsValid(Itr)) continue;
-		if (Itr->HasAnyFlags(RF_ClassDefaultObject)) continue;
-		if (Itr->IsActorBeingDestroyed()) continue;
+		for (const auto& Source : WorldPartitionSubsystem->GetStreamingSources())
+		{
+			OutLocations.Add(Source.Location);
+		}
+	}
 
-		if (FGuid Id; LIBRARY::IsSaveInterfaceObject(Itr, Id))
+	// No world partition streaming source, use players view points.
+	if (OutLocations.Num() == 0)
+	{
+		for (auto Itr = World->GetPlayerControllerIterator(); Itr; ++Itr)
 		{
-			if (!bCollectOnly)
+			if (const APlayerController* PlayerController = Itr->Get())
 			{
-				Itr->OnDestroyed.RemoveAll(this);
+				FVector Location;
+				FRotator Rotation;
+				PlayerController->GetPlayerViewPoint(Location, Rotation);
+				OutLocations.Add(Location);
 			}
-			FInstancedStruct SaveDataStruct;
-			StoreObjectUnsafe(Itr, SaveDataStruct);
-			SaveData->SaveDatas.Add(Id, SaveDataStruct);
 		}
-		StoreActorComponents(Itr, SaveData->SaveDatas);
 	}
 }
 
-void UStreamingLevelSaveSubsystem::RestorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData)
+double UStreamingLevelSaveSubsystem::GetClosestSourceDistanceSquared(const TArray<FVector>& SourceLocations, const FVector& Location)
 {
-	if (!SaveData || !Level)
+	double Result = UE_DOUBLE_BIG_NUMBER;
+	for (const auto& Itr : SourceLocations)
 	{
-		return;
+		Result = FMath::Min(Result, FVector::DistSquared(Itr, Location));
 	}
 	
-	for (auto Itr : Level->Actors)
+	return Result;
+}
+
+bool UStreamingLevelSaveSubsystem::EnsureSaveDataRestored(AActor* Actor)
+{
+	FPendingRestore Pending;
+	if (!Actor || !PendingRestores.RemoveAndCopyValue(Actor, Pending))
 	{
-		if (!IsValid(Itr)) continue;
-		if (Itr->HasAnyFlags(RF_ClassDefaultObject)) continue;
-		if (Itr->IsActorBeingDestroyed()) continue;
-		
-		FGuid Id;
-		if (LIBRARY::IsSaveInterfaceObject(Itr, Id))
+		return false;
+	}
+
+	ApplyPendingRestore(Pending);
+	return true;
+}
+
+bool UStreamingLevelSaveSubsystem::HasChangedWhilePending(const FPendingRestore& Pending) const
+{
+	const auto Actor = Pending.Actor.Get();
+	return Pending.bTracksDirty && IsValid(Actor) && INTERFACE::Execute_IsSaveDataDirty(Actor);
+}
+
+void UStreamingLevelSaveSubsystem::ApplyPendingRestore(const FPendingRestore& Pending)
+{
+	const auto Actor = Pending.Actor.Get();
+	if (!IsValid(Actor) || Actor->IsActorBeingDestroyed())
+	{
+		return;
+	}
+
+	// Restoring would overwrite what changed, next store takes live state instead.
+	if (HasChangedWhilePending(Pending))
+	{
+		if (const auto SaveData = FindTempData(Pending.LevelName))
 		{
-			// Destroy state.
-			if (SaveData->DestroyedActors.Find(Id) >= 0)
-			{
-				Itr->Destroy(true);
-			}
-			else
-			{
-				if (const auto FoundData = SaveData->SaveDatas.Find(Id))
-				{
-					RestoreObjectUnsafe(Itr, *FoundData);
-				}
-				else
-				{
-					// If not destroyed we execute post load save data.
-					INTERFACE::Execute_PostLoadSaveData(Itr);
-				}
-				
-				Itr->OnDestroyed.AddDynamic(this, &ThisClass::OnLevelActorDestroyed);
-			}
+			RestoreActorComponents(Actor, SaveData->SaveDatas);
 		}
-		RestoreActorComponents(Itr, SaveData->SaveDatas);
+		return;
+	}
+
+	// Collecting store may have switched datas to dense layout since restore was deferred.
+	const FInstancedStruct* FoundData = nullptr;
+	if (const auto SaveData = FindTempData(Pending.LevelName))
+	{
+		const auto Layout = DenseLayouts.Find(Pending.LevelName);
+		const auto DenseIndex = Layout && SaveData->Dense.IsValid() && SaveData->Dense.LayoutHash == Layout->Hash
+			? Layout->DenseIndexByGuid.Find(Pending.Id) : nullptr;
+		FoundData = DenseIndex ? &SaveData->Dense.SaveDatas[*DenseIndex] : SaveData->SaveDatas.Find(Pending.Id);
+	}
+
+	if (FoundData && FoundData->IsValid())
+	{
+		RestoreObjectUnsafe(Actor, *FoundData);
+	}
+	else
+	{
+		INTERFACE::Execute_PostLoadSaveData(Actor);
+	}
+
+	// Restoring may add temp datas and move the map, find again.
+	if (const auto SaveData = FindTempData(Pending.LevelName))
+	{
+		RestoreActorComponents(Actor, SaveData->SaveDatas);
 	}
 }
 
-void UStreamingLevelSaveSubsystem::StoreRuntimeActors(const ULevel* InLevel,
-	FStreamingLevelSaveData* SaveData, bool bCollectOnly)
+void UStreamingLevelSaveSubsystem::SettlePendingRestores(const ULevel* Level)
 {
-	TArray<UStreamingLevelSaveComponent*> Components;
-	for (const auto Itr : RuntimeActorComponents)
+	if (PendingRestores.Num() == 0)
 	{
-		// Store runtime actor
-		const auto OwnerActor = Itr->GetOwner();
-		const auto Cell = InLevel->GetWorldPartitionRuntimeCell();
-		if (Cell && Cell->GetCellBounds().IsInsideXY(OwnerActor->GetActorLocation()))
+		return;
+	}
+
+	TArray<FPendingRestore> ToRestore;
+	for (const auto Itr : Level->Actors)
+	{
+		const auto Pending = Itr ? PendingRestores.Find(Itr.Get()) : nullptr;
+		if (Pending && (!Pending->bTracksDirty || HasChangedWhilePending(*Pending)))
 		{
-			if (Itr->bSave)
-			{
-				FStreamingLevelSaveRuntimeData RuntimeData;
-				StoreRuntimeActor(Itr->GetOwner(), RuntimeData);
-				SaveData->RuntimeActorsSaveDatas.Add(RuntimeData);
-				Components.Add(Itr);
-			}
-			else
-			{
-				// Additional Feature : Destroy runtime actor if not save that.
-				Components.Add(Itr);
-			}
+			ToRestore.Add(MoveTemp(*Pending));
+			PendingRestores.Remove(Itr.Get());
 		}
 	}
-	// Remove actors.
-	if (!bCollectOnly)
+
+	// Restore outside of actors iteration, restored actors may spawn others.
+	for (const auto& Itr : ToRestore)
 	{
-		for (const auto Itr : Components)
+		ApplyPendingRestore(Itr);
+	}
+}
+
+void UStreamingLevelSaveSubsystem::TickLazyRestore(float DeltaTime)
+{
+	// Deferred actors rarely move, check distances a few times per second.
+	static constexpr double LazyRestoreCheckSeconds = 0.1;
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	if (PendingRestores.Num() == 0 || Settings->LazyRestoreDistance <= 0.f)
+	{
+		return;
+	}
+	
+	LazyRestoreElapsed += DeltaTime;
+	if (LazyRestoreElapsed < LazyRestoreCheckSeconds)
+	{
+		return;
+	}
+	LazyRestoreElapsed = 0.0;
+
+	TArray<FVector> SourceLocations;
+	GatherStreamingSourceLocations(SourceLocations);
+	if (SourceLocations.Num() == 0)
+	{
+		return;
+	}
+
+	const double RestoreDistSq = FMath::Square(static_cast<double>(Settings->LazyRestoreDistance));
+	TArray<FPendingRestore> ToRestore;
+	for (auto It = PendingRestores.CreateIterator(); It; ++It)
+	{
+		const auto Actor = It->Value.Actor.Get();
+		if (!IsValid(Actor))
 		{
-			Itr->GetOwner()->Destroy(true);
+			It.RemoveCurrent();
+		}
+		else if (GetClosestSourceDistanceSquared(SourceLocations, Actor->GetActorLocation()) <= RestoreDistSq)
+		{
+			ToRestore.Add(MoveTemp(It->Value));
+			It.RemoveCurrent();
+			if (ToRestore.Num() >= Settings->MaxLazyRestoresPerFrame)
+			{
+				// More may be in range, check again next frame.
+				LazyRestoreElapsed = LazyRestoreCheckSeconds;
+				break;
+			}
 		}
 	}
+
+	// Restore outside of map iteration, restored actors may access other deferred actors.
+	for (const auto& Itr : ToRestore)
+	{
+		ApplyPendingRestore(Itr);
+	}
 }
 
-void UStreamingLevelSaveSubsystem::StoreRuntimeActor(AActor* Actor,
-	FStreamingLevelSaveRuntimeData& RuntimeActorData)
+void UStreamingLevelSaveSubsystem::RequestAutosave()
 {
-	FInstancedStruct SaveDataStruct;
-	StoreObjectUnsafe(Actor, SaveDataStruct);
-	RuntimeActorData.AdditionalData = SaveDataStruct;
-	RuntimeActorData.ActorClass = Actor->GetClass();
-	RuntimeActorData.ActorTransform = Actor->GetActorTransform();
-	RuntimeActorData.ActorVelocity = Actor->GetVelocity();
-	StoreActorComponents(Actor, RuntimeActorData.Components);
+	if (bAutosaveInProgress || !SaveLoadSequence || SaveLoadSequence->bProgressing || !IsAllowSaving())
+	{
+		return;
+	}
+
+	// Levels are captured once frame time allows, see TickAutosave.
+	AutosaveElapsed = 0.0;
+	AutosaveDeferredFrames = 0;
+	bAutosaveInProgress = true;
+	OnPreAutosave.Broadcast();
 }
 
-void UStreamingLevelSaveSubsystem::RestoreRuntimeActors(FStreamingLevelSaveData* SaveData)
+bool UStreamingLevelSaveSubsystem::IsAutosaving() const
 {
-	for (const auto Itr : SaveData->RuntimeActorsSaveDatas)
+	return bAutosaveInProgress;
+}
+
+void UStreamingLevelSaveSubsystem::TickAutosave(float DeltaTime)
+{
+	// Commit finished, files are in slot.
+	if (AutosaveCommitTask.IsValid() && AutosaveCommitTask.IsCompleted())
+	{
+		AutosaveCommitTask = UE::Tasks::FTask();
+		bAutosaveInProgress = false;
+		OnAutosaveComplete.Broadcast();
+	}
+	
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	if (!bAutosaveInProgress)
 	{
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		if (const auto NewActor = GetWorld()->SpawnActor(Itr.ActorClass.LoadSynchronous(), &Itr.ActorTransform, SpawnParams))
+		if (Settings->bEnableAutosave && SETTINGS::GetEnableSaveLoad() && GetWorld())
 		{
-			if (NewActor->GetRootComponent())
+			AutosaveElapsed += DeltaTime;
+			if (AutosaveElapsed >= Settings->AutosaveIntervalSeconds)
 			{
-				NewActor->GetRootComponent()->ComponentVelocity = Itr.ActorVelocity;
+				RequestAutosave();
 			}
-
-			RestoreObjectUnsafe(NewActor, Itr.AdditionalData);
-			RestoreActorComponents(NewActor, Itr.Components);
 		}
+		return;
+	}
+
+	if (AutosaveCommitTask.IsValid())
+	{
+		return;
+	}
+
+	// Back off while frames are slow, but never stall autosave for good.
+	const double FrameTimeMs = DeltaTime * 1000.0;
+	if (Settings->AutosaveTargetFrameTimeMs > 0.f && FrameTimeMs > Settings->AutosaveTargetFrameTimeMs
+		&& AutosaveDeferredFrames < Settings->AutosaveMaxDeferredFrames)
+	{
+		++AutosaveDeferredFrames;
+		return;
 	}
+	AutosaveDeferredFrames = 0;
+	CommitAutosave();
+}
+
+void UStreamingLevelSaveSubsystem::CommitAutosave()
+{
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	const FString SlotName = Settings->AutosaveSlotName.IsEmpty() ? GetCurrentSaveSlotName() : Settings->AutosaveSlotName;
+	if (SlotName.IsEmpty() || SaveLoadSequence->bProgressing)
+	{
+		bAutosaveInProgress = false;
+		return;
+	}
+
+	// Every visible level is captured in this frame, a runtime actor moving between cells is saved once.
+	// Slot is written on workers like a sequence save, with fresh progress as previous sequence may have cancelled its own.
+	const FString BaseSlot = DifferentialBaseSlot;
+	SequenceProgress = MakeShared<FStreamingLevelSaveProgress, ESPMode::ThreadSafe>();
+	BeginSaveSnapshot(SlotName, SaveLoadSequence->LevelsSaveFolder);
+	// Autosave slot is overwritten often, sequence saves stay based on the slot they came from.
+	DifferentialBaseSlot = BaseSlot;
+
+	AutosaveCommitTask = IOScheduler->Enqueue(EStreamingLevelSaveIOPriority::SlotCopy, FStreamingLevelSaveSlot::MakeSlotKey(SlotName),
+		[SlotName]()
+	{
+		FStreamingLevelSaveCatalogue::UpdateSlot(SlotName);
+	}, UE_DOUBLE_BIG_NUMBER, MakeArrayView(&SaveSnapshotTask, 1));
+}
+
+void UStreamingLevelSaveSubsystem::CancelAutosave()
+{
+	AutosaveElapsed = 0.0;
+	if (AutosaveCommitTask.IsValid())
+	{
+		AutosaveCommitTask.Wait();
+		AutosaveCommitTask = UE::Tasks::FTask();
+	}
+	bAutosaveInProgress = false;
 }
 
 void UStreamingLevelSaveSubsystem::ClearAllTempFiles()
 {
+	// Nothing should read or write temp files while deleting them.
+	if (LoadCopyTask.IsValid())
+	{
+		SequenceProgress->bCancelled = true;
+		LoadCopyTask.Wait();
+	}
+	for (const auto& Pair : PendingDecodes)
+	{
+		Pair.Value.Wait();
+	}
+	PendingDecodes.Empty();
+	PendingFilterLevels.Empty();
+	WaitForPendingWrites();
+	WaitForSaveSnapshot();
+	CancelAutosave();
+	
+	LentTempDatas.Empty();
 	TempSaveDatas.Empty();
+	PreloadedLevelNames.Empty();
+	PersistentLevelCache.Empty();
+	PersistentLevelCacheOrder.Empty();
+	QuickLoadSnapshot.Reset();
+	QuickLoadPendingCells.Empty();
 	IFileManager::Get().DeleteDirectory(*LIBRARY::GetTempFileFolder(), true, true);
 }
 
@@ -522,6 +2151,8 @@ void UStreamingLevelSaveSubsystem::AssignDelegates()
 	
 	FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ThisClass::LevelAddedToWorld);
 	FWorldDelegates::PreLevelRemovedFromWorld.AddUObject(this, &ThisClass::PreLevelRemovedFromWorld);
+	FLevelStreamingDelegates::OnLevelStreamingStateChanged.AddUObject(this, &ThisClass::LevelStreamingStateChanged);
+	BindActorDestroyedHandler(ActorDestroyedWorld.Get());
 }
 
 void UStreamingLevelSaveSubsystem::RemoveDelegates()
@@ -531,6 +2162,8 @@ void UStreamingLevelSaveSubsystem::RemoveDelegates()
 	
 	FWorldDelegates::LevelAddedToWorld.RemoveAll(this);
 	FWorldDelegates::PreLevelRemovedFromWorld.RemoveAll(this);
+	FLevelStreamingDelegates::OnLevelStreamingStateChanged.RemoveAll(this);
+	UnbindActorDestroyedHandler();
 }
 
 void UStreamingLevelSaveSubsystem::TakeScreenshot()
@@ -549,6 +2182,79 @@ UTexture2D* UStreamingLevelSaveSubsystem::LoadScreenshot(const FSaveGameScreensh
 	return nullptr;
 }
 
+void UStreamingLevelSaveSubsystem::LoadScreenshotAsync(FString SlotName, FSaveGameScreenshotData PngData, FOnScreenshotLoaded OnLoaded)
+{
+	const uint64 Version = CityHash64(reinterpret_cast<const char*>(PngData.Data.GetData()), PngData.Data.Num());
+	DecodeThumbnailAsync(SlotName, Version, [Data = MoveTemp(PngData.Data)](TArray<uint8>& OutData)
+	{
+		OutData = Data;
+		return true;
+	}, OnLoaded);
+}
+
+void UStreamingLevelSaveSubsystem::LoadCatalogueThumbnailAsync(FStreamingLevelSaveCatalogueEntry Entry, FOnScreenshotLoaded OnLoaded)
+{
+	const uint64 Version = Entry.Timestamp.GetTicks();
+	DecodeThumbnailAsync(Entry.SlotName, Version, [Entry](TArray<uint8>& OutData)
+	{
+		return FStreamingLevelSaveCatalogue::LoadThumbnail(Entry, OutData);
+	}, OnLoaded);
+}
+
+void UStreamingLevelSaveSubsystem::DecodeThumbnailAsync(const FString& SlotName, uint64 Version,
+	TUniqueFunction<bool(TArray<uint8>&)>&& ReadData, const FOnScreenshotLoaded& OnLoaded)
+{
+	if (const auto Cached = ThumbnailCache.Find(SlotName); Cached && Cached->Version == Version && Cached->Texture)
+	{
+		ThumbnailCacheOrder.Remove(SlotName);
+		ThumbnailCacheOrder.Add(SlotName);
+		OnLoaded.ExecuteIfBound(Cached->Texture);
+		return;
+	}
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<ThisClass>(this), SlotName, Version,
+		ReadData = MoveTemp(ReadData), OnLoaded]()
+	{
+		TArray<uint8> Data;
+		int32 Width = 0;
+		int32 Height = 0;
+		TArray<FColor> Colors;
+		const bool bDecoded = ReadData(Data) && LIBRARY::DecodeScreenshot(Data, Width, Height, Colors);
+
+		// Textures are created on game thread.
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, SlotName, Version, bDecoded, Width, Height, Colors = MoveTemp(Colors), OnLoaded]()
+		{
+			UTexture2D* Texture = bDecoded ? LIBRARY::CreateScreenshotTexture(Width, Height, Colors) : nullptr;
+			if (Texture && WeakThis.IsValid())
+			{
+				WeakThis->CacheThumbnail(SlotName, Version, Texture);
+			}
+			OnLoaded.ExecuteIfBound(Texture);
+		});
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
+}
+
+void UStreamingLevelSaveSubsystem::CacheThumbnail(const FString& SlotName, uint64 Version, UTexture2D* Texture)
+{
+	const auto MaxCached = GetDefault<UStreamingLevelSaveSettings>()->MaxCachedThumbnails;
+	if (MaxCached <= 0)
+	{
+		return;
+	}
+
+	auto& Cached = ThumbnailCache.FindOrAdd(SlotName);
+	Cached.Texture = Texture;
+	Cached.Version = Version;
+	ThumbnailCacheOrder.Remove(SlotName);
+	ThumbnailCacheOrder.Add(SlotName);
+
+	while (ThumbnailCacheOrder.Num() > MaxCached)
+	{
+		ThumbnailCache.Remove(ThumbnailCacheOrder[0]);
+		ThumbnailCacheOrder.RemoveAt(0);
+	}
+}
+
 void UStreamingLevelSaveSubsystem::AddDestroyedLevelActor(const FStreamingLevelActorData InData)
 {
 	if (InData.IsValid())
@@ -562,6 +2268,13 @@ void UStreamingLevelSaveSubsystem::AddDestroyedLevelActor(const FStreamingLevelA
 
 void UStreamingLevelSaveSubsystem::OnLevelActorDestroyed(AActor* DestroyedActor)
 {
+	// Called for every actor of world, only tracked ones are recorded.
+	if (TrackedActors.Remove(DestroyedActor) == 0)
+	{
+		return;
+	}
+
+	PendingRestores.Remove(DestroyedActor);
 	if (const ULevel* Level = INTERFACE::Execute_GetAssociateLevel(DestroyedActor))
 	{
 		if (const auto Found = GetOrAddTempCellSaveData(LIBRARY::GetLevelName(Level)))
@@ -576,17 +2289,33 @@ void UStreamingLevelSaveSubsystem::OnScreenshotCaptured(int32 Width, int32 Heigh
 	const auto ViewportClient = UGameplayStatics::GetPlayerController(GetWorld(), 0)->GetLocalPlayer()->ViewportClient;
 	ViewportClient->OnScreenshotCaptured().RemoveAll(this);
 	
-	// Convert down to PNG
-	TArray<uint8> PngData;
-	FImageUtils::ThumbnailCompressImageArray(Width, Height, Colors, PngData);
-	
-	ScreenShotCaptured.Broadcast(FSaveGameScreenshotData(PngData));
+	// Downscale and encode on a worker, broadcast once done.
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis = TWeakObjectPtr<ThisClass>(this), Width, Height, Colors,
+		MaxSize = Settings->ScreenshotMaxSize, bJpeg = Settings->bEncodeScreenshotsAsJpeg, Quality = Settings->ScreenshotJpegQuality]()
+	{
+		int32 ScaledWidth = 0;
+		int32 ScaledHeight = 0;
+		TArray<FColor> Scaled;
+		LIBRARY::DownscaleScreenshot(Width, Height, Colors, MaxSize, ScaledWidth, ScaledHeight, Scaled);
+
+		TArray<uint8> PngData;
+		LIBRARY::EncodeScreenshot(ScaledWidth, ScaledHeight, Scaled, bJpeg, Quality, PngData);
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, PngData = MoveTemp(PngData)]()
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->ScreenShotCaptured.Broadcast(FSaveGameScreenshotData(PngData));
+			}
+		});
+	}, UE::Tasks::ETaskPriority::BackgroundNormal);
 }
 
 void UStreamingLevelSaveSubsystem::PostLoadMapWithWorld(UWorld* World)
 {
 	// Clear temp files when load these maps/
-	if (GetDefault<UStreamingLevelSaveSettings>()->PostLoadMapClearTemp.Contains(World->GetCurrentLevel()->GetName()))
+	// Quick loaded map reads temp files written from its snapshot, keep them.
+	if (!bQuickLoading && GetDefault<UStreamingLevelSaveSettings>()->PostLoadMapClearTemp.Contains(World->GetCurrentLevel()->GetName()))
 	{
 		ClearAllTempFiles();
 	}
@@ -596,14 +2325,26 @@ void UStreamingLevelSaveSubsystem::PostLoadMapWithWorld(UWorld* World)
 		VisibleStreamingLevels.Add(World->PersistentLevel);
 		LoadLevelInternal(World->PersistentLevel);
 	}
+
+	// Quick loaded map is open, levels may be saved again.
+	if (bQuickLoading)
+	{
+		bQuickLoading = false;
+		OnLoadComplete.Broadcast();
+	}
 }
 
 void UStreamingLevelSaveSubsystem::PreLoadMapWithContext(const FWorldContext& WorldContext, const FString& String)
 {
+	// Pooled actors belong to the world being unloaded.
+	ClearRuntimeActorPools();
+	// Autosave of the old map finishes before its levels are gone.
+	CancelAutosave();
+	
 	if (!WorldContext.World()->GetWorldPartition() && WorldContext.World()->GetNetMode() != NM_Client)
 	{
-		// Do not save files because now is loading files and opening new level.
-		if (SaveLoadSequence && !SaveLoadSequence->bProgressing)
+		// Loading sequence is replacing temp files, saving sequence works on its own snapshot.
+		if (SaveLoadSequence && !IsLoading())
 		{
 			VisibleStreamingLevels.Remove(WorldContext.World()->PersistentLevel);
 			SaveLevelInternal(WorldContext.World()->PersistentLevel, false, true);
@@ -615,17 +2356,50 @@ void UStreamingLevelSaveSubsystem::LevelAddedToWorld(ULevel* Level, UWorld* Worl
 {
 	if (World && World->GetNetMode() != NM_Client)
 	{
+		SessionRecorder.Record(EStreamingLevelSaveRecordEvent::LevelAdded, LIBRARY::GetLevelName(Level));
 		VisibleStreamingLevels.Add(Level);
 		LoadLevelInternal(Level);
 	}
 }
 
+void UStreamingLevelSaveSubsystem::LevelStreamingStateChanged(UWorld* World, const ULevelStreaming* LevelStreaming,
+	ULevel* LevelIfLoaded, ELevelStreamingState PreviousState, ELevelStreamingState NewState)
+{
+	if (!World || !World->IsGameWorld() || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	// Decode while level package is loading.
+	if (NewState == ELevelStreamingState::Loading && LevelStreaming && Settings->bDecodeCellDataOnWorkers)
+	{
+		const auto StreamingLevelName = LIBRARY::GetLevelName(LevelStreaming->GetWorldAssetPackageName());
+		if (!Settings->IgnoreLevelNames.Contains(StreamingLevelName))
+		{
+			const auto CellStreaming = Cast<UWorldPartitionLevelStreamingDynamic>(LevelStreaming);
+			BeginDecodeCell(StreamingLevelName, GetCellDistanceSquared(CellStreaming ? CellStreaming->GetWorldPartitionRuntimeCell() : nullptr));
+			SessionRecorder.Record(EStreamingLevelSaveRecordEvent::BeginDecode, StreamingLevelName);
+		}
+	}
+	
+	// Only freshly loaded levels, made invisible levels keep their actors.
+	if (PreviousState == ELevelStreamingState::Loading && NewState == ELevelStreamingState::LoadedNotVisible && LevelIfLoaded)
+	{
+		if (Settings->bFilterDestroyedActorsOnLoad)
+		{
+			FilterDestroyedActors(LevelIfLoaded);
+		}
+	}
+}
+
 void UStreamingLevelSaveSubsystem::PreLevelRemovedFromWorld(ULevel* Level, UWorld* World)
 {
 	if (World && World->GetNetMode() != NM_Client)
 	{
-		// Do not save files because now is loading files and opening new level.
-		if (SaveLoadSequence && !SaveLoadSequence->bProgressing)
+		SessionRecorder.Record(EStreamingLevelSaveRecordEvent::LevelRemoved, LIBRARY::GetLevelName(Level));
+		// Loading sequence is replacing temp files, saving sequence works on its own snapshot.
+		if (SaveLoadSequence && !IsLoading())
 		{
 			VisibleStreamingLevels.Remove(Level);
 			SaveLevelInternal(Level, false, true);
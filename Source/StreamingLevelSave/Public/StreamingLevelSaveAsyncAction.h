@@ -0,0 +1,67 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "Tickable.h"
+#include "StreamingLevelSaveAsyncAction.generated.h"
+
+class UStreamingLevelSaveSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FStreamingLevelSaveAsyncActionPin, int32, CellsDone, int32, CellsTotal, int64, BytesDone);
+
+/** Runs a save or load sequence, slot files are copied on workers. Completes once saved files are durable. */
+UCLASS()
+class STREAMINGLEVELSAVE_API UStreamingLevelSaveAsyncAction : public UBlueprintAsyncActionBase, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"))
+	static UStreamingLevelSaveAsyncAction* AsyncSaveGame(UObject* WorldContextObject, FString SaveFileName, bool bMultiplay, bool bLan);
+
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"))
+	static UStreamingLevelSaveAsyncAction* AsyncLoadGame(UObject* WorldContextObject, FString SaveFileName, bool bMultiplay, bool bLan);
+
+	/** Stop copying files, OnFailed fires. Does nothing once files are copied. */
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save")
+	void Cancel();
+
+	/** Fires every frame while running. */
+	UPROPERTY(BlueprintAssignable)
+	FStreamingLevelSaveAsyncActionPin OnProgress;
+
+	UPROPERTY(BlueprintAssignable)
+	FStreamingLevelSaveAsyncActionPin OnCompleted;
+
+	/** Cancelled, failed, or another sequence was running. */
+	UPROPERTY(BlueprintAssignable)
+	FStreamingLevelSaveAsyncActionPin OnFailed;
+
+	virtual void Activate() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return bRunning; }
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	// FTickableGameObject
+
+private:
+	UFUNCTION()
+	void OnSequenceComplete();
+
+	UFUNCTION()
+	void OnSequenceFailed();
+
+	void Finish(bool bSuccess);
+
+	UPROPERTY()
+	UStreamingLevelSaveSubsystem* Subsystem = nullptr;
+
+	FString SlotName;
+	bool bSave = true;
+	bool bSessionMultiplay = false;
+	bool bSessionLan = false;
+	bool bRunning = false;
+};
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "StreamingLevelSaveStructs.h"
+
+/**
+ * Index of save slots kept in SaveGames folder, updated when a slot is saved, deleted or renamed.
+ * Slot thumbnails are packed in one file next to it. Safe to call on workers.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveCatalogue
+{
+public:
+	/** Add or refresh slot from its folder. Null metadata or thumbnail keeps the catalogued one. */
+	static bool UpdateSlot(const FString& SlotName, const TMap<FString, FString>* MetaData = nullptr,
+		const TArray<uint8>* Thumbnail = nullptr);
+
+	static void RemoveSlot(const FString& SlotName);
+	static void RenameSlot(const FString& OldSlotName, const FString& NewSlotName);
+
+	/** Rescan slots whose folder changed since catalogued, add and drop slots changed outside catalogue. Lists save games folder only. */
+	static void Refresh();
+
+	/** Entries of page, newest first. Returns number of entries in catalogue. */
+	static int32 Query(int32 PageIndex, int32 PageSize, TArray<FStreamingLevelSaveCatalogueEntry>& OutEntries);
+	static TArray<FStreamingLevelSaveCatalogueEntry> GetAllEntries();
+
+	static bool LoadThumbnail(const FStreamingLevelSaveCatalogueEntry& Entry, TArray<uint8>& OutPngData);
+
+private:
+	static FString GetIndexPath();
+	static FString GetThumbnailsPath();
+
+	// Lock must be held. Scans save games folder once if there is no index yet.
+	static TArray<FStreamingLevelSaveCatalogueEntry>& GetEntries();
+	static bool SaveIndex();
+	static void ScanSlot(const FString& SlotName, FStreamingLevelSaveCatalogueEntry& Entry);
+	static bool IsSlotFolderName(const FString& Name);
+	static int64 AppendThumbnail(const TArray<uint8>& PngData);
+	static void CompactThumbnails();
+};
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "StreamingLevelSaveStructs.h"
+
+class FStreamingLevelSaveReaderProxy;
+
+enum class EStreamingLevelSaveCellFileVersion : int32
+{
+	// No header, written before file versioning.
+	Legacy = 0,
+	// Body is written in bounded, optionally compressed chunks, with dense datas and packed runtime actors.
+	Chunked = 1,
+
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1
+};
+
+/**
+ * Reads and writes cell save data files.
+ * Cells are streamed from and to the file archive in bounded chunks, peak memory does not depend on cell size.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveCellFile
+{
+public:
+	// "SLSV", files without it are legacy files.
+	static constexpr uint32 Magic = 0x56534C53;
+
+	/** Runtime actor payloads are moved out of the data while it is written and moved back after, do not read it meanwhile. */
+	static bool Save(const FString& FilePath, FStreamingLevelSaveData& SaveData);
+	/** Off game thread, fails if records reference types which are not loaded. Decode it again on game thread then. */
+	static bool Load(const FString& FilePath, FStreamingLevelSaveData& SaveData);
+
+	/** Same format as files, for cells kept in memory. */
+	static bool SaveToMemory(TArray<uint8>& OutBytes, FStreamingLevelSaveData& SaveData);
+	static bool LoadFromMemory(TConstArrayView<uint8> Bytes, const FString& DebugName, FStreamingLevelSaveData& SaveData);
+
+	/** Serialize cell data which follows the file header. */
+	static void SerializeBody(FArchive& Ar, FStreamingLevelSaveData& SaveData, int32 Version);
+
+private:
+	static bool SaveToArchive(FArchive& FileWriter, FStreamingLevelSaveData& SaveData);
+	// Read header and body, mapped view is the whole file when it is memory mapped.
+	static bool LoadFromArchive(FArchive& FileReader, const FString& FilePath, FStreamingLevelSaveData& SaveData,
+		TArrayView<const uint8> Mapped);
+	static bool IsMissingTypes(const FStreamingLevelSaveReaderProxy& ReaderProxy, const FString& FilePath);
+
+	// False if records cannot be packed, they are written plain then. Payloads are moved into packed data, not copied.
+	static bool PackRuntimeActors(TArray<FStreamingLevelSaveRuntimeData>& Records, float Precision,
+		FStreamingLevelSavePackedRuntimeData& OutPacked);
+	// Move payloads back into the records they were packed from.
+	static void ReturnPackedPayloads(FStreamingLevelSavePackedRuntimeData& Packed, TArray<FStreamingLevelSaveRuntimeData>& Records);
+	static void UnpackRuntimeActors(FStreamingLevelSavePackedRuntimeData& Packed, TArray<FStreamingLevelSaveRuntimeData>& OutRecords);
+};
@@ -8,6 +8,8 @@
 
 class UStreamingLevelSaveSubsystem;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FStreamingLevelSavePoolDelegate);
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class STREAMINGLEVELSAVE_API UStreamingLevelSaveComponent : public UActorComponent
 {
@@ -25,6 +27,22 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming Level Save")
 	float VelocityThreshold = 0.1f;
 
+	// Allow subsystem to dehydrate this actor when it is far away from every streaming source.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming Level Save")
+	bool bAllowDehydration = true;
+
+	// Allow owner to be deactivated and reused instead of destroyed, owner must reset its own gameplay state.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Streaming Level Save")
+	bool bAllowPooling = false;
+
+	// Called after owner is deactivated and returned to pool.
+	UPROPERTY(BlueprintAssignable, Category = "Streaming Level Save")
+	FStreamingLevelSavePoolDelegate OnReturnedToPool;
+
+	// Called after owner is taken from pool and its save data is restored.
+	UPROPERTY(BlueprintAssignable, Category = "Streaming Level Save")
+	FStreamingLevelSavePoolDelegate OnTakenFromPool;
+
 protected:
 	UStreamingLevelSaveSubsystem* GetSubsystem() const;
 	
@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "StreamingLevelSaveSettings.h"
+
+/**
+ * Writes whole files under a durability policy. PerFile writes each file aside, flushes and renames it.
+ * Staged writes files without flushing and flushes each of them on Commit, meant for a staging folder
+ * which is then swapped into place. Safe to use on workers, one writer per thread.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveFileWriter
+{
+public:
+	explicit FStreamingLevelSaveFileWriter(EStreamingLevelSaveDurability InDurability);
+
+	bool Write(const FString& FilePath, TConstArrayView<uint8> Data);
+	bool Copy(const FString& DestPath, const FString& SourcePath);
+
+	/** Flush every file written since last commit. */
+	bool Commit();
+
+	EStreamingLevelSaveDurability GetDurability() const { return Durability; }
+
+	/** Flush written file to disk. */
+	static bool FlushFile(const FString& FilePath);
+
+	static FString GetStagingFolder(const FString& Folder);
+
+	/** Replace folder by its staging folder. A crash in between is repaired by RecoverFolder. */
+	static bool SwapInStagingFolder(const FString& Folder);
+
+	/** Finish a swap interrupted by a crash. Call before reading folder. Staging and old folders are left alone. */
+	static void RecoverFolder(const FString& Folder);
+
+private:
+	const EStreamingLevelSaveDurability Durability;
+	TArray<FString> UnflushedFiles;
+};
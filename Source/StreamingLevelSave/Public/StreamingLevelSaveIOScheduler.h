@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+/** I/O job classes, lower value runs first. */
+enum class EStreamingLevelSaveIOPriority : uint8
+{
+	// Game thread is waiting for this read.
+	UrgentRead,
+	// Level started loading, its data is needed soon.
+	PrefetchRead,
+	UnloadWrite,
+	SlotCopy,
+
+	Num
+};
+
+/**
+ * Runs temp file reads and writes on a few workers, highest priority class first and nearest cell first within a class.
+ * Distance never reorders jobs across classes. Urgent reads also get an extra foreground worker, so they do not wait
+ * behind running slot copies or normal engine background work.
+ * Jobs with same key run in enqueue order, so writes and reads of a cell never overlap.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveIOScheduler : public TSharedFromThis<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe>
+{
+public:
+	explicit FStreamingLevelSaveIOScheduler(int32 InMaxConcurrentJobs);
+
+	/** Queue work, returned task completes after it ran. Empty key is not ordered with other jobs. */
+	UE::Tasks::FTask Enqueue(EStreamingLevelSaveIOPriority Priority, const FString& Key, TUniqueFunction<void()>&& Work,
+		double DistanceSquared = UE_DOUBLE_BIG_NUMBER, TConstArrayView<UE::Tasks::FTask> Prerequisites = {});
+
+	/** Raise queued jobs of key to priority, so a read is not stuck behind the writes it depends on. */
+	void Promote(const FString& Key, EStreamingLevelSaveIOPriority Priority);
+
+	int32 GetQueueDepth() const;
+
+private:
+	struct FJob
+	{
+		FString Key;
+		TUniqueFunction<void()> Work;
+		EStreamingLevelSaveIOPriority Priority = EStreamingLevelSaveIOPriority::Num;
+		double DistanceSquared = 0.0;
+		uint64 Sequence = 0;
+		double EnqueueTime = 0.0;
+		// Prerequisites are done.
+		bool bReady = false;
+		UE::Tasks::FTaskEvent Done{ UE_SOURCE_LOCATION };
+	};
+
+	void MarkReady(const TSharedRef<FJob, ESPMode::ThreadSafe>& Job);
+	// Lock must be held.
+	void StartWorkers();
+	// Lock must be held.
+	TSharedPtr<FJob, ESPMode::ThreadSafe> PopBestJob(bool bUrgentOnly);
+	// Urgent worker only runs urgent reads.
+	void WorkerLoop(bool bUrgent);
+	// Lock must be held.
+	void UpdateQueueStats() const;
+
+	const int32 MaxConcurrentJobs;
+	mutable FCriticalSection Mutex;
+	// Jobs not started yet, ready or waiting for prerequisites.
+	TArray<TSharedRef<FJob, ESPMode::ThreadSafe>> QueuedJobs;
+	// Completion of last job of each key.
+	TMap<FString, UE::Tasks::FTask> LastTaskByKey;
+	int32 RunningWorkers = 0;
+	int32 RunningUrgentWorkers = 0;
+	uint64 NextSequence = 0;
+};
@@ -63,6 +63,14 @@ public:
 	void LoadSaveData(const FInstancedStruct& SaveData);
 	virtual void LoadSaveData_Implementation(const FInstancedStruct& SaveData);
 
+	/**
+	 * False if state did not change since last LoadSaveData or GetSaveData, loaded data is then written back without GetSaveData.
+	 * Implementations clear their flag in both calls and set it on every change of saved state.
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Streaming Level Save")
+	bool IsSaveDataDirty() const;
+	virtual bool IsSaveDataDirty_Implementation() const { return true; }
+
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Streaming Level Save")
 	void PostLoadSaveData();
 	virtual void PostLoadSaveData_Implementation() {}
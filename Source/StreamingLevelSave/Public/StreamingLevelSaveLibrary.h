@@ -38,6 +38,20 @@ public:
 	 */
 	static ULevel* GetAssociateLevelDefault(const AActor* Actor);
 
+	/** Box filter colors down to fit MaxSize, alpha is made opaque. Safe on workers. */
+	static void DownscaleScreenshot(int32 Width, int32 Height, TConstArrayView<FColor> Colors, int32 MaxSize,
+		int32& OutWidth, int32& OutHeight, TArray<FColor>& OutColors);
+
+	/** Encode BGRA colors to png or jpeg. Safe on workers once image wrapper module is loaded. */
+	static bool EncodeScreenshot(int32 Width, int32 Height, TConstArrayView<FColor> Colors, bool bJpeg, int32 Quality,
+		TArray<uint8>& OutData);
+
+	/** Decode png or jpeg to BGRA colors. Safe on workers once image wrapper module is loaded. */
+	static bool DecodeScreenshot(TConstArrayView<uint8> Data, int32& OutWidth, int32& OutHeight, TArray<FColor>& OutColors);
+
+	/** Game thread only. */
+	static UTexture2D* CreateScreenshotTexture(int32 Width, int32 Height, const TArray<FColor>& Colors);
+
 	/** Init determined guid with given string. */
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save")
 	static void InitGuidFromString(FString String, UPARAM(ref)FGuid& Guid);
@@ -55,6 +69,10 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save|Interface")
 	static ULevel* GetAssociateLevelInternal(UObject* Object);
+
+	/** Apply saved state deferred by lazy restore to actor or owner of component. False if nothing was deferred. */
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save|Interface")
+	static bool EnsureSaveDataRestored(UObject* Object);
 	// Interface ============
 
 	UFUNCTION(BlueprintPure, Category = "Streaming Level Save|Save Game")
@@ -63,9 +81,13 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Streaming Level Save|Save Game")
 	static bool IsDirectoryExistInSaveGame(FString DirectoryName);
 
+	/** Slot files are deleted on a worker, after saves of slot already queued. */
 	UFUNCTION(BlueprintCallable)
 	static bool DeleteSaveGame(FString SaveGameName);
 
+	UFUNCTION(BlueprintCallable)
+	static bool RenameSaveGame(FString SaveGameName, FString NewSaveGameName);
+
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	static bool GetLevelActorData(AActor* Actor, FStreamingLevelActorData& OutData);
 };
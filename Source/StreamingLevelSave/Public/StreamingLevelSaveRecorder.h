@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EStreamingLevelSaveRecordEvent : uint8
+{
+	LevelAdded,
+	LevelRemoved,
+	BeginDecode,
+	SaveLevel,
+	LoadLevel,
+	BeginSequence,
+	EndSequence,
+};
+
+enum class EStreamingLevelSaveRecordFlags : uint8
+{
+	None = 0,
+	OnlyCollect = 1 << 0,
+	Async = 1 << 1,
+	Saving = 1 << 2,
+};
+ENUM_CLASS_FLAGS(EStreamingLevelSaveRecordFlags);
+
+struct FStreamingLevelSaveRecordedEvent
+{
+	// Seconds since recording started.
+	double Time = 0.0;
+	EStreamingLevelSaveRecordEvent Event = EStreamingLevelSaveRecordEvent::LevelAdded;
+	// Cell or slot name.
+	FString Name;
+	EStreamingLevelSaveRecordFlags Flags = EStreamingLevelSaveRecordFlags::None;
+	// Game thread time spent, zero for events which only mark a point in time.
+	double DurationMs = 0.0;
+};
+
+/**
+ * Records level streaming and save events of a session to a csv file, one line per event.
+ * Sessions are read back by the StreamingLevelSaveReplay commandlet. Game thread only.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveRecorder
+{
+public:
+	void Start(const FString& InFilePath);
+	void Stop();
+	bool IsRecording() const { return !FilePath.IsEmpty(); }
+
+	void Record(EStreamingLevelSaveRecordEvent Event, const FString& Name,
+		EStreamingLevelSaveRecordFlags Flags = EStreamingLevelSaveRecordFlags::None, double StartSeconds = 0.0);
+
+	/** Append recorded lines to file. */
+	void Flush();
+
+	/** New file in Saved/StreamingLevelSave/Sessions named by current time. */
+	static FString MakeSessionPath();
+	static bool LoadSession(const FString& InFilePath, TArray<FStreamingLevelSaveRecordedEvent>& OutEvents);
+
+private:
+	FString FilePath;
+	double StartTime = 0.0;
+	TArray<FString> PendingLines;
+};
+
+STREAMINGLEVELSAVE_API const TCHAR* LexToString(EStreamingLevelSaveRecordEvent Event);
+STREAMINGLEVELSAVE_API bool LexTryParseString(EStreamingLevelSaveRecordEvent& OutEvent, const TCHAR* String);
@@ -8,6 +8,7 @@
 #include "StreamingLevelSaveSequence.generated.h"
 
 class USaveGame;
+struct FStreamingLevelSaveProgress;
 
 UCLASS(BlueprintType, Blueprintable)
 class STREAMINGLEVELSAVE_API UStreamingLevelSaveSequence : public UObject
@@ -35,6 +36,14 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Base")
 	FString LevelsSaveFolder = "Levels";
 
+	/** Listed with slot in save catalogue, set it in BeginSave. */
+	UPROPERTY(BlueprintReadWrite, Category = "Catalogue")
+	TMap<FString, FString> CatalogueMetaData;
+
+	/** Png listed with slot in save catalogue, set it in BeginSave. */
+	UPROPERTY(BlueprintReadWrite, Category = "Catalogue")
+	FSaveGameScreenshotData CatalogueThumbnail;
+
 	UFUNCTION(BlueprintPure, Category = "Streaming Level Save")
 	FString GetSaveSlotName(FString SlotName) const;
 
@@ -63,6 +72,9 @@ public:
 
 	void CopyTempFilesToSavePath() const;
 	void CopySaveFilesToTempPath() const;
+	// Safe on workers. False if copy failed or was cancelled.
+	static bool CopySaveFilesToTempPath(const FString& InSaveFileName, const FString& InLevelsSaveFolder,
+		FStreamingLevelSaveProgress* Progress = nullptr);
 
 	void SetSubsystem(UStreamingLevelSaveSubsystem* InSubsystem) { Subsystem = InSubsystem; }
 	
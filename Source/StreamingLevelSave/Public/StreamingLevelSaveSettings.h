@@ -7,6 +7,28 @@
 #include "UObject/Object.h"
 #include "StreamingLevelSaveSettings.generated.h"
 
+UENUM()
+enum class EStreamingLevelSaveSlotStorage : uint8
+{
+	// Every slot stores every cell.
+	Full,
+	// Slot stores cells changed since slot it was loaded from or last saved to.
+	Differential,
+	// Slot references cells by hash, identical cells are stored once for all slots.
+	ContentAddressed
+};
+
+UENUM()
+enum class EStreamingLevelSaveDurability : uint8
+{
+	// Write in place, never flush.
+	None,
+	// Write every file aside, flush and rename it.
+	PerFile,
+	// Write slot into a staging folder, flush its files before swapping it into place. A failed save keeps previous slot.
+	Staged
+};
+
 UCLASS(Config = StreamingLevelSave, DefaultConfig)
 class STREAMINGLEVELSAVE_API UStreamingLevelSaveSettings : public UObject
 {
@@ -17,6 +39,8 @@ public:
 	static bool GetClearTempFilesOnEndGame();
 	static TSubclassOf<UStreamingLevelSaveSequence> GetDefaultSaveSequenceClass();
 	static FString GetTempFileFolder();
+	/** Use another temp folder in this process, so tools never touch temp files of game. Empty restores configured one. */
+	static void SetTempFileFolderOverride(const FString& Folder);
 
 public:
 	UPROPERTY(Config, EditAnywhere)
@@ -36,4 +60,135 @@ public:
 	
 	UPROPERTY(Config, EditAnywhere)
 	FString TempSaveFilesFolder = "TempLevels";
+
+	/** Destroy recorded destroyed actors once their level is loaded and decoded, if that is before it is added to world. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bFilterDestroyedActorsOnLoad = true;
+
+	/** Read and decode cell data on worker threads while the level is loading.
+	 * Workers never load objects, cells referencing script structs which are not loaded yet are decoded again on game thread.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bDecodeCellDataOnWorkers = true;
+
+	/** Store persistent actors by dense index of the cooked level instead of guid mappings. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bUseDenseCellLayout = false;
+
+	/** Size of chunks cell files are written and read in, bounds extra memory used while streaming a cell file. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = 4, ClampMax = 65536))
+	int32 CellFileChunkSizeKB = 256;
+
+	/** Compression format of cell file chunks, None to write uncompressed chunks. */
+	UPROPERTY(Config, EditAnywhere)
+	FName CellFileCompressionFormat = NAME_Oodle;
+
+	/** Write runtime actor records packed: class table, quantized transforms, sparse velocities. Transforms lose precision. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bPackRuntimeActors = false;
+
+	/** Finest step packed positions are quantized to, coarser for cells whose records span more than two million steps. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bPackRuntimeActors", ClampMin = "0.001"))
+	float PackedPositionPrecision = 0.1f;
+
+	/** Persistent levels of non world partition maps kept in memory after map travel, returning restores them without reading temp file. 0 to disable. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 MaxCachedPersistentLevels = 4;
+
+	/** Temp file reads and writes running at the same time, stream in reads are picked first. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1", ClampMax = "16"))
+	int32 MaxConcurrentIOJobs = 2;
+
+	/** Read cell files through a memory mapped view on platforms which support it. Compare with -ReadBench of replay commandlet first. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bMemoryMapCellFiles = false;
+
+	/** Store and destroy runtime actors far away from every streaming source, respawn them when a source comes back. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bEnableRuntimeActorDehydration = false;
+
+	/** Runtime actors further than this from every streaming source are dehydrated. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableRuntimeActorDehydration", ClampMin = "0"))
+	float DehydrationDistance = 25600.f;
+
+	/** Dehydrated actors closer than this to any streaming source are respawned. Keep it below DehydrationDistance. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableRuntimeActorDehydration", ClampMin = "0"))
+	float RehydrationDistance = 19200.f;
+
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableRuntimeActorDehydration", ClampMin = "1"))
+	int32 MaxDehydrationsPerFrame = 16;
+
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableRuntimeActorDehydration", ClampMin = "1"))
+	int32 MaxRehydrationsPerFrame = 8;
+
+	/**
+	 * Defer saved state of persistent actors until first access instead of restoring it when cell is added.
+	 * Actors clean by IsSaveDataDirty when deferred and unchanged at store write their loaded data back without GetSaveData,
+	 * changed ones store live state and others are restored before store.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bLazyRestorePersistentActors = false;
+
+	/** Deferred actors closer than this to any streaming source are restored, keep it past their cull distance. 0 restores on access only. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bLazyRestorePersistentActors", ClampMin = "0"))
+	float LazyRestoreDistance = 25600.f;
+
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bLazyRestorePersistentActors", ClampMin = "1"))
+	int32 MaxLazyRestoresPerFrame = 32;
+
+	/** Max deactivated runtime actors kept per class for reuse, 0 to disable pooling. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 MaxPooledRuntimeActorsPerClass = 0;
+
+	/** Quick save snapshots kept in memory, oldest is dropped first. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 MaxQuickSaveSnapshots = 3;
+
+	UPROPERTY(Config, EditAnywhere)
+	EStreamingLevelSaveSlotStorage SlotStorage = EStreamingLevelSaveSlotStorage::Full;
+
+	/** How slot and temp file writes survive a crash. Temp files are only written aside and flushed with PerFile. */
+	UPROPERTY(Config, EditAnywhere)
+	EStreamingLevelSaveDurability Durability = EStreamingLevelSaveDurability::None;
+
+	/** Differential slot is compacted in background once this many slots are chained behind it. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "SlotStorage == EStreamingLevelSaveSlotStorage::Differential", ClampMin = "1"))
+	int32 MaxDifferentialChainLength = 8;
+
+	/** Periodically snapshot visible cells in one frame and commit them to autosave slot in background. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bEnableAutosave = false;
+
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableAutosave", ClampMin = "1"))
+	float AutosaveIntervalSeconds = 300.f;
+
+	/** Skip snapshotting while frame time is above this, 0 to never back off. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableAutosave", ClampMin = "0"))
+	float AutosaveTargetFrameTimeMs = 33.3f;
+
+	/** Snapshot anyway after backing off this many frames in a row. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableAutosave", ClampMin = "0"))
+	int32 AutosaveMaxDeferredFrames = 60;
+
+	/** Save game slot autosaves are committed to, current save slot if empty. */
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEnableAutosave"))
+	FString AutosaveSlotName = "Autosave";
+
+	/** Captured screenshots are downscaled on a worker to fit this size before encoding. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "16"))
+	int32 ScreenshotMaxSize = 512;
+
+	UPROPERTY(Config, EditAnywhere)
+	bool bEncodeScreenshotsAsJpeg = false;
+
+	UPROPERTY(Config, EditAnywhere, meta = (EditCondition = "bEncodeScreenshotsAsJpeg", ClampMin = "1", ClampMax = "100"))
+	int32 ScreenshotJpegQuality = 85;
+
+	/** Decoded thumbnails kept by slot, least recently used is dropped first. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 MaxCachedThumbnails = 16;
+
+	/** Record level streaming and save events of each session to a csv in Saved/StreamingLevelSave/Sessions, for replay. */
+	UPROPERTY(Config, EditAnywhere)
+	bool bRecordSessions = false;
 };
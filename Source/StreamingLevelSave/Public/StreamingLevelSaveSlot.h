@@ -0,0 +1,140 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "StreamingLevelSaveSettings.h"
+#include "Misc/SecureHash.h"
+#include "Tasks/Task.h"
+
+#include <atomic>
+
+class FStreamingLevelSaveFileWriter;
+class FStreamingLevelSaveIOScheduler;
+
+/** Progress of a slot copy, updated on a worker and polled on game thread. */
+struct FStreamingLevelSaveProgress
+{
+	std::atomic<int32> CellsDone{ 0 };
+	std::atomic<int32> CellsTotal{ 0 };
+	std::atomic<int64> BytesDone{ 0 };
+	// Set by game thread, copy stops at next cell.
+	std::atomic<bool> bCancelled{ false };
+	std::atomic<bool> bFailed{ false };
+};
+
+/** Size and SHA-1 of a cell file. Checked when cell is read back, 64 bit hashes alone may collide. */
+struct FStreamingLevelSaveCellDigest
+{
+	int64 Size = 0;
+	FSHAHash Sha;
+
+	bool operator==(const FStreamingLevelSaveCellDigest& Other) const { return Size == Other.Size && Sha == Other.Sha; }
+	bool operator!=(const FStreamingLevelSaveCellDigest& Other) const { return !(*this == Other); }
+
+	friend FArchive& operator<<(FArchive& Ar, FStreamingLevelSaveCellDigest& Digest)
+	{
+		return Ar << Digest.Size << Digest.Sha;
+	}
+};
+
+/**
+ * Cells of a slot levels folder. Differential slots only store cells which changed since their base slot,
+ * other cells are read from the newest slot in the base chain which stores them.
+ * Content addressed slots store no cells, every cell is read from the shared cell store by hash.
+ */
+struct STREAMINGLEVELSAVE_API FStreamingLevelSaveSlotManifest
+{
+	static const TCHAR* FileName;
+
+	FString SlotName;
+	FString LevelsFolderName;
+	// Empty for a slot which stores every cell.
+	FString BaseSlot;
+	int32 ChainLength = 0;
+	bool bContentAddressed = false;
+	// Hash of every cell in resolved slot, by cell file name.
+	TMap<FString, uint64> CellHashes;
+	// Digest of every cell in resolved slot, by cell file name.
+	TMap<FString, FStreamingLevelSaveCellDigest> CellDigests;
+	// Cells stored in this slot folder.
+	TSet<FString> StoredCells;
+	// Slots based on this one. May list slots rebased or saved in full since, check their base slot.
+	TSet<FString> Dependants;
+
+	bool IsDifferential() const { return !BaseSlot.IsEmpty(); }
+	FString GetLevelsFolder() const;
+
+	bool Load(const FString& LevelsFolder);
+	bool Save(const FString& LevelsFolder) const;
+	bool Save(const FString& LevelsFolder, FStreamingLevelSaveFileWriter& Writer) const;
+	void Serialize(FArchive& Ar);
+};
+
+/** Chain resolution and compaction of slots, safe to call on workers. */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveSlot
+{
+public:
+	static FString MakeLevelsFolder(const FString& SaveGameName, const FString& LevelsFolderName);
+	static uint64 HashFile(const FString& FilePath);
+
+	/** Hash and digest of file. False if it cannot be read. */
+	static void DigestBytes(TConstArrayView<uint8> Bytes, uint64& OutHash, FStreamingLevelSaveCellDigest& OutDigest);
+	static bool DigestFile(const FString& FilePath, uint64& OutHash, FStreamingLevelSaveCellDigest& OutDigest);
+
+	/** Load cell of manifest, false if it does not match the digest manifest recorded for it. */
+	static bool LoadVerifiedCell(const FStreamingLevelSaveSlotManifest& Manifest, const FString& CellFileName,
+		const FString& FilePath, TArray<uint8>& OutBytes);
+
+	/** Copy newest version of every cell of slot to folder. False if slot has no manifest. */
+	static bool ResolveToFolder(const FString& SaveGameName, const FString& LevelsFolderName, const FString& DestFolder,
+		FStreamingLevelSaveProgress* Progress = nullptr);
+
+	/** Copy cells slot reads from its base chain into it, slot no longer depends on other slots. */
+	static bool Compact(const FString& SaveGameName, const FString& LevelsFolderName);
+
+	/** Compact every slot based on this one. Call before overwriting or deleting it. Only reads dependants index. */
+	static void DetachDependants(const FString& SaveGameName);
+
+	/** Record that dependant is now based on, or no longer based on, base slot. Empty name adds or removes nothing. */
+	static void UpdateDependantIndex(const FString& BaseSlot, const FString& LevelsFolderName, const FString& Removed,
+		const FString& Added);
+
+	/** Rewrite manifests of a slot folder moved to new name, and rebase slots based on it instead of compacting them. */
+	static void RenameSlot(const FString& OldSaveGameName, const FString& NewSaveGameName);
+
+	/** Hold while reading and rewriting a manifest other slots may update. */
+	static FCriticalSection& GetManifestLock();
+
+	/** Scheduler slot maintenance runs on. Without one, maintenance runs on calling thread. */
+	static void SetScheduler(const TSharedPtr<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe>& InScheduler);
+
+	/** Run work on scheduler after queued jobs of slot. Invalid task if it ran already. */
+	static UE::Tasks::FTask EnqueueMaintenance(const FString& SaveGameName, TUniqueFunction<void()>&& Work);
+
+	/** Scheduler key of jobs reading or writing a slot folder. */
+	static FString MakeSlotKey(const FString& SaveGameName);
+
+	/** Cell files shared by content addressed slots, named by hash. */
+	static FString GetCellStoreDir();
+	static FString MakeCellStorePath(uint64 Hash);
+
+	/**
+	 * Copy file into cell store unless same cell is stored already. False if it could not be stored,
+	 * or another cell with same hash is stored, then the slot must store the cell itself.
+	 */
+	static bool AddToCellStore(const FString& SourcePath, uint64 Hash, const FStreamingLevelSaveCellDigest& Digest,
+		EStreamingLevelSaveDurability Durability = EStreamingLevelSaveDurability::None);
+
+	/** Delete stored cells no content addressed slot references. Catalogue must list the slots saved so far. */
+	static void CollectGarbage();
+
+	/** Hold from adding cells to store until manifest referencing them is saved, so garbage collection keeps them. */
+	static FCriticalSection& GetCellStoreLock();
+
+private:
+	// File storing cell, walking base chain from manifest.
+	static FString FindStoredCell(const FStreamingLevelSaveSlotManifest& Manifest, const FString& CellFileName);
+	// Manifests of every catalogued slot, staging and old copies included.
+	static TArray<FString> FindManifestFiles();
+	// Manifests of levels folders of slot, without staging or old copies.
+	static TArray<FStreamingLevelSaveSlotManifest> LoadSlotManifests(const FString& SaveGameName);
+};
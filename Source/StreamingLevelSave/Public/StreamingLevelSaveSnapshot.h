@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "StreamingLevelSaveSettings.h"
+#include "Tasks/Task.h"
+
+struct FStreamingLevelSaveProgress;
+
+/**
+ * Versioned snapshot of temp files taken when a save sequence begins, copied to the save folder on a worker.
+ * Writers preserve a temp file before overwriting it until the snapshot has copied it, copy on write.
+ * Differential storage copies only cells which differ from base slot, content addressed storage copies cells to cell store.
+ */
+class STREAMINGLEVELSAVE_API FStreamingLevelSaveSnapshot
+{
+public:
+	FStreamingLevelSaveSnapshot(int32 InVersion, const FString& InSaveGameName, const FString& InLevelsFolderName,
+		EStreamingLevelSaveSlotStorage InStorage = EStreamingLevelSaveSlotStorage::Full, const FString& InBaseSlot = FString(),
+		int32 InMaxChainLength = 0);
+	~FStreamingLevelSaveSnapshot();
+
+	FStreamingLevelSaveSnapshot(const FStreamingLevelSaveSnapshot&) = delete;
+	FStreamingLevelSaveSnapshot& operator=(const FStreamingLevelSaveSnapshot&) = delete;
+
+	/** Record existing temp files and levels still being written as members of snapshot. Game thread only. */
+	void Capture(const TArray<FString>& WritingLevelNames);
+
+	/** Move temp file of level aside if snapshot did not copy it yet. Call before overwriting it. */
+	void PreserveFile(const FString& LevelStreamingName);
+
+	/** Copy snapshot version of member files to save folder and write its manifest. */
+	bool CopyToSaveFolder();
+
+	/**
+	 * Report copy progress. Cancelling keeps previous slot with staged durability, differential or content addressed storage,
+	 * else slot is left partially updated.
+	 */
+	void SetProgress(const TSharedPtr<FStreamingLevelSaveProgress, ESPMode::ThreadSafe>& InProgress) { Progress = InProgress; }
+
+	int32 GetVersion() const { return Version; }
+
+private:
+	static FString GetFileName(const FString& LevelStreamingName);
+
+	const int32 Version;
+	const FString SaveGameName;
+	const FString LevelsFolderName;
+	const EStreamingLevelSaveSlotStorage Storage;
+	const FString BaseSlot;
+	// Differential slot is compacted once its chain reaches this length.
+	const int32 MaxChainLength;
+	const FString TempDir;
+	// Temp files overwritten during snapshot are moved here.
+	const FString PreservedFolder;
+
+	TSharedPtr<FStreamingLevelSaveProgress, ESPMode::ThreadSafe> Progress;
+
+	FCriticalSection Mutex;
+	// Member files not copied yet.
+	TSet<FString> PendingFiles;
+};
+
+/** Whole world quick save kept in memory, every cell encoded in cell file format. */
+struct FStreamingLevelSaveQuickSnapshot
+{
+	FDateTime Time;
+	// Encoded cell file of each level.
+	TMap<FString, TArray<uint8>> Cells;
+	// Encodes captured cells and reads other temp files, Cells is only valid once done.
+	UE::Tasks::FTask BuildTask;
+};
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+
+LLM_DECLARE_TAG_API(StreamingLevelSave, STREAMINGLEVELSAVE_API);
+
+DECLARE_STATS_GROUP(TEXT("StreamingLevelSave"), STATGROUP_StreamingLevelSave, STATCAT_Advanced);
+
+// Deep copies, should stay at zero while streaming cells in and out.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Cell Data Copies"), STAT_StreamingLevelSave_CellDataCopies, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Runtime Record Copies"), STAT_StreamingLevelSave_RuntimeRecordCopies, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Cells Decoded On Workers"), STAT_StreamingLevelSave_WorkerDecodes, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Cell"), STAT_StreamingLevelSave_DecodeCell, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+// Compare mapped and buffered reads of the same cells, first load of a cell hits a cold page cache.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Mapped Cell Reads"), STAT_StreamingLevelSave_MappedReads, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mapped Cell Read"), STAT_StreamingLevelSave_MappedRead, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Buffered Cell Read"), STAT_StreamingLevelSave_BufferedRead, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Persistent Level Cache Hits"), STAT_StreamingLevelSave_PersistentLevelCacheHits, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wait Decode Cell"), STAT_StreamingLevelSave_WaitDecodeCell, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+
+// I/O scheduler queue and how long the last job of each class waited in it.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("IO Queue Depth"), STAT_StreamingLevelSave_IOQueueDepth, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("IO Wait Urgent Read (ms)"), STAT_StreamingLevelSave_IOWaitUrgentRead, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("IO Wait Prefetch Read (ms)"), STAT_StreamingLevelSave_IOWaitPrefetchRead, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("IO Wait Unload Write (ms)"), STAT_StreamingLevelSave_IOWaitUnloadWrite, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("IO Wait Slot Copy (ms)"), STAT_StreamingLevelSave_IOWaitSlotCopy, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+
+// Objects captured with GetSaveData and objects whose loaded data was written back as is.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Objects Stored"), STAT_StreamingLevelSave_StoredObjects, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Objects Kept Unchanged"), STAT_StreamingLevelSave_UnchangedObjects, STATGROUP_StreamingLevelSave, STREAMINGLEVELSAVE_API);
+
+enum class EStreamingLevelSaveCopyCounter : uint8
+{
+	CellData,
+	RuntimeRecord
+};
+
+/** Member of save structs which counts deep copies of its owner, moves are not counted. */
+template <EStreamingLevelSaveCopyCounter Counter>
+struct TStreamingLevelSaveCopyCounter
+{
+	TStreamingLevelSaveCopyCounter() = default;
+	TStreamingLevelSaveCopyCounter(TStreamingLevelSaveCopyCounter&&) = default;
+	TStreamingLevelSaveCopyCounter& operator=(TStreamingLevelSaveCopyCounter&&) = default;
+	
+	TStreamingLevelSaveCopyCounter(const TStreamingLevelSaveCopyCounter&)
+	{
+		Count();
+	}
+	
+	TStreamingLevelSaveCopyCounter& operator=(const TStreamingLevelSaveCopyCounter&)
+	{
+		Count();
+		return *this;
+	}
+
+private:
+	static void Count()
+	{
+		if constexpr (Counter == EStreamingLevelSaveCopyCounter::CellData)
+		{
+			INC_DWORD_STAT(STAT_StreamingLevelSave_CellDataCopies);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_StreamingLevelSave_RuntimeRecordCopies);
+		}
+	}
+};
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "StreamingLevelSaveStats.h"
 #include "StructUtils/InstancedStruct.h"
 #include "StreamingLevelSaveStructs.generated.h"
 
@@ -23,6 +24,129 @@ struct FStreamingLevelSaveRuntimeData
 	
 	UPROPERTY(BlueprintReadOnly)
 	FInstancedStruct AdditionalData;
+
+	TStreamingLevelSaveCopyCounter<EStreamingLevelSaveCopyCounter::RuntimeRecord> CopyCounter;
+};
+
+/** Runtime actor records in structure of arrays form, written instead of plain records when packing is enabled. */
+USTRUCT()
+struct FStreamingLevelSavePackedRuntimeData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TSoftClassPtr<AActor>> Classes;
+
+	/** Index in class table by record. */
+	UPROPERTY()
+	TArray<uint16> ClassIndices;
+
+	/** Min corner of record locations, positions are offsets from it. */
+	UPROPERTY()
+	FVector PositionOrigin = FVector::ZeroVector;
+
+	UPROPERTY()
+	double PositionStep = 0.0;
+
+	/** 21 bits per axis, in steps from origin. */
+	UPROPERTY()
+	TArray<uint64> Positions;
+
+	/** Smallest three quaternion components in 10 bits each, index of dropped largest component in top 2 bits. */
+	UPROPERTY()
+	TArray<uint32> Rotations;
+
+	/** Records whose scale is not one, and their scales. */
+	UPROPERTY()
+	TArray<int32> ScaledIndices;
+
+	UPROPERTY()
+	TArray<FVector3f> Scales;
+
+	/** Records whose velocity is not zero, and their velocities. */
+	UPROPERTY()
+	TArray<int32> MovingIndices;
+
+	UPROPERTY()
+	TArray<FVector3f> Velocities;
+
+	UPROPERTY()
+	TArray<FInstancedStruct> AdditionalDatas;
+
+	/** Component count by record, guids and datas of all records back to back. */
+	UPROPERTY()
+	TArray<int32> ComponentCounts;
+
+	UPROPERTY()
+	TArray<FGuid> ComponentGuids;
+
+	UPROPERTY()
+	TArray<FInstancedStruct> ComponentDatas;
+
+	int32 Num() const
+	{
+		return ClassIndices.Num();
+	}
+};
+
+/** Persistent actor datas by dense index of a cooked level layout. */
+USTRUCT()
+struct FStreamingLevelSaveDenseData
+{
+	GENERATED_BODY()
+
+	/** Hash of the layout these datas were stored with, zero if not used. */
+	UPROPERTY()
+	uint32 LayoutHash = 0;
+
+	/** Actor guids by dense index, used to expand datas when layout changed. */
+	UPROPERTY()
+	TArray<FGuid> Guids;
+
+	UPROPERTY()
+	TArray<FInstancedStruct> SaveDatas;
+
+	UPROPERTY()
+	TArray<uint32> DestroyedBits;
+
+	bool IsValid() const
+	{
+		return LayoutHash != 0 && Guids.Num() == SaveDatas.Num();
+	}
+
+	bool IsDestroyed(int32 Index) const
+	{
+		return DestroyedBits.IsValidIndex(Index / 32) && (DestroyedBits[Index / 32] & (1u << (Index % 32))) != 0;
+	}
+
+	void SetDestroyed(int32 Index)
+	{
+		DestroyedBits[Index / 32] |= 1u << (Index % 32);
+	}
+
+	void Init(uint32 InLayoutHash, const TArray<FGuid>& InGuids)
+	{
+		LayoutHash = InLayoutHash;
+		Guids = InGuids;
+		SaveDatas.Reset();
+		SaveDatas.SetNum(Guids.Num());
+		DestroyedBits.Reset();
+		DestroyedBits.SetNumZeroed(FMath::DivideAndRoundUp(Guids.Num(), 32));
+	}
+};
+
+/** Dense indices of saveable persistent actors of one cooked level, built at runtime and never saved. */
+struct FStreamingLevelSaveDenseLayout
+{
+	uint32 Hash = 0;
+	
+	// By index in ULevel::Actors.
+	TArray<FName> ActorNames;
+	TArray<int32> DenseIndices;
+	
+	// By dense index.
+	TArray<FGuid> Guids;
+	TMap<FGuid, int32> DenseIndexByGuid;
 };
 
 USTRUCT(BlueprintType)
@@ -40,6 +164,40 @@ struct FStreamingLevelSaveData
 	
 	UPROPERTY(BlueprintReadOnly)
 	TArray<FStreamingLevelSaveRuntimeData> RuntimeActorsSaveDatas;
+
+	/** Runtime actors dehydrated while the cell is still loaded, merged into RuntimeActorsSaveDatas when storing. */
+	UPROPERTY(Transient)
+	TArray<FStreamingLevelSaveRuntimeData> DehydratedRuntimeActors;
+
+	/** Optional dense layout of persistent actors, serialized after the datas above. */
+	UPROPERTY(Transient)
+	FStreamingLevelSaveDenseData Dense;
+
+	TStreamingLevelSaveCopyCounter<EStreamingLevelSaveCopyCounter::CellData> CopyCounter;
+};
+
+/** Deactivated runtime actor and the state it had before it was pooled. */
+USTRUCT()
+struct FStreamingLevelSavePooledActor
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AActor* Actor = nullptr;
+
+	bool bHidden = false;
+	bool bCollisionEnabled = true;
+	bool bTickEnabled = true;
+};
+
+/** Deactivated runtime actors of one class waiting to be reused. */
+USTRUCT()
+struct FStreamingLevelSaveActorPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FStreamingLevelSavePooledActor> Actors;
 };
 
 USTRUCT(BlueprintType)
@@ -51,6 +209,55 @@ struct FSaveGameScreenshotData
 	TArray<uint8> Data;
 };
 
+/** Decoded screenshot of a slot, version tells whether it is still current. */
+USTRUCT()
+struct FStreamingLevelSaveCachedThumbnail
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UTexture2D* Texture = nullptr;
+
+	uint64 Version = 0;
+};
+
+/** Save slot as listed in save catalogue, read without touching slot folder. */
+USTRUCT(BlueprintType)
+struct FStreamingLevelSaveCatalogueEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FString SlotName;
+
+	/** Last save to slot, UTC. */
+	UPROPERTY(BlueprintReadOnly)
+	FDateTime Timestamp;
+
+	UPROPERTY(BlueprintReadOnly)
+	int64 SizeBytes = 0;
+
+	/** Offset of thumbnail png in catalogue thumbnails file, -1 if slot has none. */
+	UPROPERTY(BlueprintReadOnly)
+	int64 ThumbnailOffset = -1;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 ThumbnailSize = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	TMap<FString, FString> MetaData;
+
+	/** Save game files at root of slot folder. */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FString> RootFiles;
+
+	// Files in subfolders of slot, relative to it. Serialized by catalogue after properties.
+	TArray<FString> NestedFiles;
+
+	// Modification time of slot folder when it was scanned, slot is rescanned once folder changes.
+	FDateTime FolderTimestamp;
+};
+
 USTRUCT(BlueprintType)
 struct FStreamingLevelActorData
 {
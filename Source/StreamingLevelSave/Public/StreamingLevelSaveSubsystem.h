@@ -2,15 +2,26 @@
 
 #include "CoreMinimal.h"
 #include "StreamingLevelSaveComponent.h"
+#include "StreamingLevelSaveRecorder.h"
 #include "StreamingLevelSaveStructs.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Tasks/Task.h"
 #include "StreamingLevelSaveSubsystem.generated.h"
 
 class UStreamingLevelSaveSequence;
 class UStreamingLevelSaveComponent;
+class ULevelStreaming;
+class FStreamingLevelSaveSnapshot;
+struct FStreamingLevelSaveQuickSnapshot;
+struct FStreamingLevelSaveProgress;
+class FStreamingLevelSaveIOScheduler;
+class UWorldPartitionRuntimeCell;
+enum class ELevelStreamingState : uint8;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FSaveGameDelegate);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnScreenshotCapturedBlueprint, FSaveGameScreenshotData, Data);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnScreenshotLoaded, UTexture2D*, Texture);
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnSaveCatalogueQueried, const TArray<FStreamingLevelSaveCatalogueEntry>&, Entries, int32, TotalCount);
 
 UCLASS()
 class STREAMINGLEVELSAVE_API UStreamingLevelSaveSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
@@ -34,13 +45,29 @@ public:
 
 	UPROPERTY(BlueprintAssignable)
 	FSaveGameDelegate OnLoadComplete;
+
+	// Sequence was cancelled or its files could not be copied.
+	UPROPERTY(BlueprintAssignable)
+	FSaveGameDelegate OnSaveLoadFailed;
+
+	UPROPERTY(BlueprintAssignable)
+	FSaveGameDelegate OnPreAutosave;
+
+	// Cell files are committed to autosave slot, save other game datas here.
+	UPROPERTY(BlueprintAssignable)
+	FSaveGameDelegate OnAutosaveComplete;
 	
 	UPROPERTY(BlueprintReadOnly)
 	TSet<UStreamingLevelSaveComponent*> RuntimeActorComponents;
 	
+	// Data of a collected level is moved out while its temp file is written.
 	UPROPERTY(BlueprintReadOnly)
 	TMap<FString, FStreamingLevelSaveData> TempSaveDatas;
 
+	// Deactivated runtime actors per class.
+	UPROPERTY()
+	TMap<UClass*, FStreamingLevelSaveActorPool> RuntimeActorPools;
+
 	UPROPERTY(BlueprintReadOnly)
 	TSet<const ULevel*> VisibleStreamingLevels;
 
@@ -69,8 +96,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	void BeginSaveLoadSequence(FString SaveFileName, bool bSaving, bool bMultiplay, bool bLan);
 
+	// Save ends once its files are durable in slot, possibly on a later frame.
 	void EndSaveLoadSequence();
 
+	// Stop copying sequence files, sequence ends as failed. False if files are copied already.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	bool CancelSaveLoadSequence();
+
+	UFUNCTION(BlueprintPure, Category = "Streaming Level Save Subsystem")
+	void GetSaveLoadProgress(int32& CellsDone, int32& CellsTotal, int64& BytesDone) const;
+
 	UFUNCTION(BlueprintPure, Category = "Streaming Level Save Subsystem")
 	bool IsAllowSaving() const;
 	
@@ -80,11 +115,55 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Streaming Level Save Subsystem")
 	bool IsLoading() const;
 	// Saving Loading ==========================
+
+	// Quick save ==========================
+	// Snapshot whole world into memory, newest snapshot is index 0.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void QuickSave();
+
+	// Restore visible levels in place from snapshot in memory, others decode from it when streamed in.
+	// Map is reopened only if an actor destroyed since snapshot must come back.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	bool QuickLoad(int32 SnapshotIndex = 0);
+
+	// Write snapshot cells to save slot in background.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void FlushQuickSave(int32 SnapshotIndex, FString SaveFileName);
+
+	UFUNCTION(BlueprintPure, Category = "Streaming Level Save Subsystem")
+	int32 GetNumQuickSaves() const;
+	// Quick save ==========================
+
+	// Autosave ==========================
+	// Snapshot visible cells in one of next frames, once frame time allows, and commit them to autosave slot in background.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void RequestAutosave();
+
+	UFUNCTION(BlueprintPure, Category = "Streaming Level Save Subsystem")
+	bool IsAutosaving() const;
+	// Autosave ==========================
+
+	// Lazy restore ==========================
+	// Apply deferred saved state of actor now, call before reading or changing its state. False if nothing was deferred.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	bool EnsureSaveDataRestored(AActor* Actor);
+	// Lazy restore ==========================
 	
 	TArray<FString> CollectTempSaveFiles();
 
+	// Snapshot temp files and copy them to save folder on a worker, levels keep streaming meanwhile.
+	void BeginSaveSnapshot(const FString& SaveGameName, const FString& LevelsFolderName);
+	void WaitForSaveSnapshot();
+
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	TArray<FString> FindMetaDataFiles(FString MetaDataFileName);
+
+	// Read a page of save catalogue on a worker, newest slot first. Callback runs on game thread.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void QuerySaveCatalogue(int32 PageIndex, int32 PageSize, FOnSaveCatalogueQueried OnQueried);
+
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	FSaveGameScreenshotData LoadCatalogueThumbnail(const FStreamingLevelSaveCatalogueEntry& Entry);
 	
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	void ClearAllTempFiles();
@@ -104,8 +183,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	UTexture2D* LoadScreenshot(FSaveGameScreenshotData PngData);
 
+	// Decode screenshot of slot on a worker, texture is cached by slot. Callback runs on game thread.
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void LoadScreenshotAsync(FString SlotName, FSaveGameScreenshotData PngData, FOnScreenshotLoaded OnLoaded);
+
+	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
+	void LoadCatalogueThumbnailAsync(FStreamingLevelSaveCatalogueEntry Entry, FOnScreenshotLoaded OnLoaded);
+
 	UFUNCTION(BlueprintCallable, Category = "Streaming Level Save Subsystem")
 	void AddDestroyedLevelActor(const FStreamingLevelActorData InData);
+
+	// Session replay ======
+	// Drive cell reads and writes like level events of a session would, without levels. Nothing is captured or restored.
+	void ReplayBeginDecode(const FString& LevelStreamingName);
+	void ReplaySaveLevel(const FString& LevelStreamingName, const FStreamingLevelSaveData& SaveData, bool bOnlyCollect, bool bAsync);
+	void ReplayLoadLevel(const FString& LevelStreamingName);
+	// Wait for every temp file write.
+	void ReplayFlush();
+	// Session replay ======
 	
 protected:
 	// Used to identify current loaded save game slot name.
@@ -117,39 +212,226 @@ protected:
 	// Tickable Object Interface
 	virtual void Tick(float DeltaTime);
 	virtual ETickableTickType GetTickableTickType() const { return ETickableTickType::Always; }
+	// Save and load sequences complete from a pause menu too.
+	virtual bool IsTickableWhenPaused() const override { return true; }
 	virtual TStatId GetStatId() const override;
 	// Tickable Object Interface
 	
 private:
+	// Levels whose temp data was already loaded before being added to world.
+	TSet<FString> PreloadedLevelNames;
+
+	// Cell datas decoding on worker threads, keyed by level name.
+	TMap<FString, UE::Tasks::TTask<TSharedPtr<FStreamingLevelSaveData>>> PendingDecodes;
+
+	// Last temp file write of each level, reads of the same level wait for it.
+	TMap<FString, UE::Tasks::FTask> PendingWrites;
+
+	// Persistent levels left by map travel, most recent last. Their temp files are written behind.
+	TMap<FString, TSharedPtr<FStreamingLevelSaveData>> PersistentLevelCache;
+	TArray<FString> PersistentLevelCacheOrder;
+
+	// Decoded slot screenshots, most recent last.
+	UPROPERTY(Transient)
+	TMap<FString, FStreamingLevelSaveCachedThumbnail> ThumbnailCache;
+	TArray<FString> ThumbnailCacheOrder;
+
+	// Quick save snapshots, newest first.
+	TArray<TSharedPtr<FStreamingLevelSaveQuickSnapshot>> QuickSnapshots;
+	// Snapshot being quick loaded, levels not streamed in yet decode from it.
+	TSharedPtr<FStreamingLevelSaveQuickSnapshot> QuickLoadSnapshot;
+	TSet<FString> QuickLoadPendingCells;
+	bool bQuickLoading = false;
+
+	// Runs temp file reads, writes and slot copies by priority.
+	TSharedPtr<FStreamingLevelSaveIOScheduler, ESPMode::ThreadSafe> IOScheduler;
+
+	// Snapshot of running save sequence or autosave, writers preserve files it has not copied yet.
+	TSharedPtr<FStreamingLevelSaveSnapshot> ActiveSaveSnapshot;
+	UE::Tasks::FTask SaveSnapshotTask;
+	int32 SaveSnapshotVersion = 0;
+	// File copy progress of running sequence or autosave.
+	TSharedPtr<FStreamingLevelSaveProgress, ESPMode::ThreadSafe> SequenceProgress;
+	// Copies slot into temp folder before sequence begins loading.
+	UE::Tasks::FTask LoadCopyTask;
+	// Sequence finished, waiting for save snapshot to be durable.
+	bool bSequenceEndPending = false;
+
+	// Slot next differential save is based on, last slot loaded or saved.
+	FString DifferentialBaseSlot;
+
+	// Dense actor layout of each level, built once per session on first load.
+	TMap<FString, FStreamingLevelSaveDenseLayout> DenseLayouts;
+
 	// Save temp data.
-	static bool SaveTempData(const FString& LevelStreamingName, const FStreamingLevelSaveData& SaveData);
+	static bool SaveTempData(const FString& LevelStreamingName, FStreamingLevelSaveData& SaveData);
 	// Load temp data.
 	static bool LoadTempData(const FString& LevelStreamingName, FStreamingLevelSaveData& SaveData);
 
+	// Capture level into temp data, null if level is ignored.
+	FStreamingLevelSaveData* CaptureLevelInternal(const ULevel* Level, bool bOnlyCollect);
 	// Save level ptr.
 	void SaveLevelInternal(const ULevel* Level, bool bOnlyCollect, bool bAsync = true);
 	// Load level ptr.
 	void LoadLevelInternal(const ULevel* Level);
+	// Write captured temp data of level to its temp file.
+	void WriteLevelData(const FString& StreamingLevelName, FStreamingLevelSaveData* Found, bool bOnlyCollect, bool bAsync,
+		bool bPersistentLevel, double DistanceSquared);
+	// Read temp data of level from prefetch, persistent level cache or its temp file.
+	void ReadLevelData(const FString& StreamingLevelName, FStreamingLevelSaveData& OutData);
+
+	// Temp data of collected level is lent to its write instead of copied, level keeps storing into it once moved back.
+	struct FLentTempData
+	{
+		TSharedPtr<FStreamingLevelSaveData> Data;
+		UE::Tasks::FTask Write;
+	};
+	TMap<FString, FLentTempData> LentTempDatas;
+	// Temp data of cell, lent data is moved back first.
+	FStreamingLevelSaveData* FindTempData(const FString& CellName);
+	// Move lent data of cell back, waits for its write.
+	void ReclaimTempData(const FString& CellName);
+	void ReclaimWrittenTempDatas();
+
+	// Broadcast sequence result, snapshot and load copy are done.
+	void FinishSaveLoadSequence();
+	// Continue sequence once its copies finished, also runs while paused.
+	void TickSequence();
+
+	void CachePersistentLevel(const FString& LevelStreamingName, const TSharedPtr<FStreamingLevelSaveData>& SaveData);
+
+	// Cached texture is used while version matches, else ReadData runs on a worker and its result is decoded there.
+	void DecodeThumbnailAsync(const FString& SlotName, uint64 Version, TUniqueFunction<bool(TArray<uint8>&)>&& ReadData,
+		const FOnScreenshotLoaded& OnLoaded);
+	void CacheThumbnail(const FString& SlotName, uint64 Version, UTexture2D* Texture);
+	// Move cached persistent level data out, false if not cached.
+	bool TakeCachedPersistentLevel(const FString& LevelStreamingName, FStreamingLevelSaveData& OutData);
+
+	// Start reading and decoding temp data on a worker.
+	void BeginDecodeCell(const FString& LevelStreamingName, double DistanceSquared = UE_DOUBLE_BIG_NUMBER);
+	// Move decoded temp data out, decode in place if not started.
+	bool FinishDecodeCell(const FString& LevelStreamingName, FStreamingLevelSaveData& OutData);
+	void WaitForPendingWrites();
+	// Distance from cell to closest streaming source, used to order I/O.
+	double GetCellDistanceSquared(const UWorldPartitionRuntimeCell* Cell) const;
 	
 	// Unsafe store object.
 	static void StoreObjectUnsafe(UObject* Object, FInstancedStruct& SaveData);
+	// Store object unless it has data already and reports no change, data is then kept as is.
+	static void StoreObjectIfDirty(UObject* Object, FInstancedStruct& SaveData);
 	// Unsafe restore object.
 	static void RestoreObjectUnsafe(UObject* Object, const FInstancedStruct& SaveData);
 
 	// Store actor components
 	static void StoreActorComponents(const AActor* Actor, TMap<FGuid, FInstancedStruct>& Mappings);
-	// Restore actor components
-	static void RestoreActorComponents(const AActor* Actor, const TMap<FGuid, FInstancedStruct>& Mappings);
+	// Restore actor components, skip and record restored components if given.
+	static void RestoreActorComponents(const AActor* Actor, const TMap<FGuid, FInstancedStruct>& Mappings,
+		TSet<const UActorComponent*>* RestoredComponents = nullptr);
+	
+	// Destroy persistent actors recorded as destroyed before level is added to world.
+	void FilterDestroyedActors(ULevel* Level);
+	void TickPendingFilters();
+	// Loaded levels waiting for their decode to be filtered, never waited for.
+	TArray<TWeakObjectPtr<ULevel>> PendingFilterLevels;
+
+	// Dense layout ======
+	// Layout of level, built from current actors on first call. Null if dense layout disabled.
+	const FStreamingLevelSaveDenseLayout* FindOrBuildDenseLayout(const ULevel* Level);
+	const FStreamingLevelSaveDenseLayout* FindDenseLayout(const ULevel* Level) const;
+	// Dense index of actor, by actor index first and guid if level order changed.
+	static int32 GetDenseIndex(const FStreamingLevelSaveDenseLayout& Layout, int32 ActorIndex, const AActor* Actor);
+	// Move dense datas back to guid mappings.
+	static void ExpandDenseData(FStreamingLevelSaveData& SaveData);
+	// Ids of actors recorded as destroyed, by guid or dense index.
+	static void GatherDestroyedActors(const FStreamingLevelSaveData& SaveData, TSet<FGuid>& OutIds);
+	// Dense layout ======
 	
-	void StorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData, bool bCollectOnly) const;
+	void StorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData, bool bCollectOnly);
 	void RestorePersistentActors(const ULevel* Level, FStreamingLevelSaveData* SaveData);
 
+	// Restored persistent actors, destroying one records it in temp data of its associate level.
+	TSet<TObjectKey<AActor>> TrackedActors;
+	// One actor destroyed handler on world of tracked actors instead of a binding per actor, rebinding to another world forgets tracked actors.
+	void BindActorDestroyedHandler(UWorld* World);
+	void UnbindActorDestroyedHandler();
+	TWeakObjectPtr<UWorld> ActorDestroyedWorld;
+	FDelegateHandle ActorDestroyedHandle;
+
 	void StoreRuntimeActors(const ULevel* InLevel, FStreamingLevelSaveData* SaveData, bool bCollectOnly);
 	void RestoreRuntimeActors(FStreamingLevelSaveData* SaveData);
+	AActor* RestoreRuntimeActor(const FStreamingLevelSaveRuntimeData& RuntimeActorData);
+
+	// Runtime actor spawned deferred or taken from pool, waiting for finish.
+	struct FDeferredRuntimeActor
+	{
+		AActor* Actor = nullptr;
+		const FStreamingLevelSaveRuntimeData* Data = nullptr;
+		TSet<const UActorComponent*> RestoredComponents;
+		bool bFromPool = false;
+		// State to reactivate pooled actor with.
+		FStreamingLevelSavePooledActor Pooled;
+	};
+	// Spawn deferred and restore state before construction and BeginPlay.
+	bool BeginRestoreRuntimeActor(const FStreamingLevelSaveRuntimeData& RuntimeActorData, FDeferredRuntimeActor& OutDeferred);
+	// Finish spawning and restore components created by construction.
+	void FinishRestoreRuntimeActor(FDeferredRuntimeActor& Deferred);
+
+	// Runtime actor pool ======
+	// Pool or destroy runtime actor of given component.
+	void ReleaseRuntimeActor(UStreamingLevelSaveComponent* Component, bool bAllowPool);
+	bool TakePooledRuntimeActor(UClass* ActorClass, FStreamingLevelSavePooledActor& OutPooled);
+	void ClearRuntimeActorPools();
+	// Runtime actor pool ======
+
+	// Runtime actor dehydration ======
+	void TickRuntimeActorDehydration();
+	// Find visible world partition cell level which contains actor.
+	const ULevel* FindRuntimeActorLevel(const AActor* Actor) const;
+	// Collect streaming source locations, fallback to player view points.
+	void GatherStreamingSourceLocations(TArray<FVector>& OutLocations) const;
+	static double GetClosestSourceDistanceSquared(const TArray<FVector>& SourceLocations, const FVector& Location);
+	// Runtime actor dehydration ======
+
+	// Lazy restore ======
+	// Actor restore waiting for first access, saved data stays in temp data of its level.
+	struct FPendingRestore
+	{
+		TWeakObjectPtr<AActor> Actor;
+		FString LevelName;
+		FGuid Id;
+		// Actor was clean when deferred, IsSaveDataDirty tells whether it changed since.
+		bool bTracksDirty = false;
+	};
+	bool HasChangedWhilePending(const FPendingRestore& Pending) const;
+	// Changed actor keeps its live state, only its components are restored.
+	void ApplyPendingRestore(const FPendingRestore& Pending);
+	// Before store, restore deferred actors of level which changed or cannot tell, unchanged ones keep their loaded datas.
+	void SettlePendingRestores(const ULevel* Level);
+	// Restore deferred actors near streaming sources.
+	void TickLazyRestore(float DeltaTime);
+	
+	TMap<TObjectKey<AActor>, FPendingRestore> PendingRestores;
+	double LazyRestoreElapsed = 0.0;
+	// Lazy restore ======
+
+	// Autosave ======
+	void TickAutosave(float DeltaTime);
+	// Capture visible levels and save a snapshot of temp files to autosave slot on workers.
+	void CommitAutosave();
+	void CancelAutosave();
+	
+	// Catalogues autosave slot after its snapshot is copied.
+	UE::Tasks::FTask AutosaveCommitTask;
+	double AutosaveElapsed = 0.0;
+	int32 AutosaveDeferredFrames = 0;
+	bool bAutosaveInProgress = false;
+	// Autosave ======
+
+	// Level streaming and save events, recorded when enabled in settings.
+	FStreamingLevelSaveRecorder SessionRecorder;
 
 private:
 	// Delegate bindings ======
-	UFUNCTION()
 	void OnLevelActorDestroyed(AActor* DestroyedActor);
 
 	void OnScreenshotCaptured(int32 Width, int32 Height, const TArray<FColor>& Colors);
@@ -159,5 +441,7 @@ private:
 	
 	void LevelAddedToWorld(ULevel* Level, UWorld* World);
 	void PreLevelRemovedFromWorld(ULevel* Level, UWorld* World);
+	void LevelStreamingStateChanged(UWorld* World, const ULevelStreaming* LevelStreaming, ULevel* LevelIfLoaded,
+		ELevelStreamingState PreviousState, ELevelStreamingState NewState);
 	// Delegate bindings ======
 };
@@ -40,6 +40,7 @@ public class StreamingLevelSave : ModuleRules
 				"Slate",
 				"SlateCore",
 				"CoreOnline",
+				"ImageWrapper",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
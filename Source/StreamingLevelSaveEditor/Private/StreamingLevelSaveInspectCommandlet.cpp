@@ -0,0 +1,553 @@
+﻿#include "StreamingLevelSaveInspectCommandlet.h"
+
+#include "StreamingLevelSaveCellFile.h"
+#include "StreamingLevelSaveFileWriter.h"
+#include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveSettings.h"
+#include "StreamingLevelSaveSlot.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogStreamingLevelSaveInspect, Log, All);
+
+struct FStreamingLevelSaveClassStats
+{
+	int32 Count = 0;
+	int64 Bytes = 0;
+};
+
+/** One levels folder, filled by one worker. */
+struct FStreamingLevelSaveInspectFolder
+{
+	FString Name;
+	FString Path;
+	// Cell store files are named by hash, never rewritten.
+	bool bReadOnly = false;
+
+	int32 Cells = 0;
+	int64 Bytes = 0;
+	int32 RewrittenCells = 0;
+	int64 RewrittenBytesBefore = 0;
+	int64 RewrittenBytesAfter = 0;
+	TArray<FString> CellLines;
+	TArray<FString> Errors;
+	TMap<FString, FStreamingLevelSaveClassStats> Classes;
+	TArray<FString> RewriteCells;
+	// Cells with records of structs not loaded yet, inspected again on game thread.
+	TArray<FString> GameThreadCells;
+};
+
+static bool IsStagingFolderName(const FString& Name)
+{
+	return Name.EndsWith(TEXT("_Staging")) || Name.EndsWith(TEXT("_Old"));
+}
+
+static int64 MeasureStruct(const UScriptStruct* Struct, const void* Memory, TArray<uint8>& Scratch)
+{
+	Scratch.Reset();
+	FMemoryWriter MemoryWriter(Scratch);
+	FObjectAndNameAsStringProxyArchive WriterProxy(MemoryWriter, false);
+	Struct->SerializeBin(WriterProxy, const_cast<void*>(Memory));
+	return Scratch.Num();
+}
+
+static void AddClassStats(TMap<FString, FStreamingLevelSaveClassStats>& Classes, const FString& ClassName, int64 Bytes)
+{
+	auto& Stats = Classes.FindOrAdd(ClassName);
+	Stats.Count++;
+	Stats.Bytes += Bytes;
+}
+
+static void AddRecordStats(TMap<FString, FStreamingLevelSaveClassStats>& Classes, const FInstancedStruct& Record, TArray<uint8>& Scratch)
+{
+	if (const auto Struct = Record.GetScriptStruct())
+	{
+		AddClassStats(Classes, Struct->GetName(), MeasureStruct(Struct, Record.GetMemory(), Scratch));
+	}
+}
+
+static bool ReadCellHeader(const FString& FilePath, int32& OutVersion, FName& OutFormat)
+{
+	const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	OutVersion = static_cast<int32>(EStreamingLevelSaveCellFileVersion::Legacy);
+	OutFormat = NAME_None;
+	if (Reader->TotalSize() >= static_cast<int64>(sizeof(uint32)))
+	{
+		*Reader << FileMagic;
+	}
+
+	if (FileMagic == FStreamingLevelSaveCellFile::Magic)
+	{
+		*Reader << OutVersion;
+		if (OutVersion >= static_cast<int32>(EStreamingLevelSaveCellFileVersion::Chunked))
+		{
+			FString FormatName;
+			*Reader << FormatName;
+			OutFormat = FName(*FormatName);
+		}
+	}
+	return !Reader->IsError();
+}
+
+static bool HasUnknownGuids(const FStreamingLevelSaveData& Data, const TSet<FGuid>& KnownGuids)
+{
+	if (KnownGuids.Num() == 0)
+	{
+		return false;
+	}
+
+	for (const auto& Itr : Data.DestroyedActors)
+	{
+		if (!KnownGuids.Contains(Itr))
+		{
+			return true;
+		}
+	}
+	for (const auto& Itr : Data.SaveDatas)
+	{
+		if (!KnownGuids.Contains(Itr.Key))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void CompactCell(FStreamingLevelSaveData& Data, const TSet<FGuid>& KnownGuids)
+{
+	TSet<FGuid> Seen;
+	Seen.Reserve(Data.DestroyedActors.Num());
+	Data.DestroyedActors.RemoveAll([&Seen, &KnownGuids](const FGuid& Id)
+	{
+		bool bAlreadySeen = false;
+		Seen.Add(Id, &bAlreadySeen);
+		return bAlreadySeen || (KnownGuids.Num() > 0 && !KnownGuids.Contains(Id));
+	});
+
+	// Dense datas are expanded by guid when layout changes, they are left as they are.
+	if (KnownGuids.Num() > 0)
+	{
+		for (auto Itr = Data.SaveDatas.CreateIterator(); Itr; ++Itr)
+		{
+			if (!KnownGuids.Contains(Itr.Key()))
+			{
+				Itr.RemoveCurrent();
+			}
+		}
+	}
+}
+
+static int32 CountInvalidRecords(const FStreamingLevelSaveData& Data)
+{
+	int32 InvalidRecords = 0;
+	for (const auto& Record : Data.SaveDatas)
+	{
+		InvalidRecords += Record.Key.IsValid() && Record.Value.IsValid() ? 0 : 1;
+	}
+	for (const auto& Record : Data.RuntimeActorsSaveDatas)
+	{
+		InvalidRecords += Record.ActorClass.IsNull() ? 1 : 0;
+	}
+	return InvalidRecords;
+}
+
+// Only given cells if not null, folder wide checks are skipped then.
+static void InspectFolder(FStreamingLevelSaveInspectFolder& Folder, const TSet<FGuid>& KnownGuids, bool bCompact,
+	const TArray<FString>* OnlyCells = nullptr)
+{
+	const auto Settings = GetDefault<UStreamingLevelSaveSettings>();
+	IFileManager& FileManager = IFileManager::Get();
+
+	FStreamingLevelSaveSlotManifest Manifest;
+	bool bHasManifest = FileManager.FileExists(*(Folder.Path / FStreamingLevelSaveSlotManifest::FileName));
+	if (bHasManifest && !Manifest.Load(Folder.Path))
+	{
+		if (!OnlyCells)
+		{
+			Folder.Errors.Add(TEXT("manifest is unreadable."));
+		}
+		bHasManifest = false;
+	}
+
+	TArray<FString> CellFiles;
+	if (OnlyCells)
+	{
+		CellFiles = *OnlyCells;
+	}
+	else
+	{
+		FileManager.FindFiles(CellFiles, *(Folder.Path / TEXT("*.sav")), true, false);
+	}
+	CellFiles.Sort();
+
+	TArray<uint8> Scratch;
+	for (const auto& Itr : CellFiles)
+	{
+		const FString FilePath = Folder.Path / Itr;
+		const int64 FileSize = FMath::Max<int64>(FileManager.FileSize(*FilePath), 0);
+
+		// Off game thread unloaded objects decode as null, fine for statistics. Rewrites decode again on game thread.
+		int32 Version = 0;
+		FName Format;
+		FStreamingLevelSaveData Data;
+		const bool bDecoded = ReadCellHeader(FilePath, Version, Format) && FStreamingLevelSaveCellFile::Load(FilePath, Data);
+
+		// Unloaded blueprint structs decode as invalid records off game thread, game thread load finds them.
+		const int32 InvalidRecords = bDecoded ? CountInvalidRecords(Data) : 0;
+		if (!IsInGameThread() && (!bDecoded || InvalidRecords > 0 || (Data.Dense.LayoutHash != 0 && !Data.Dense.IsValid())))
+		{
+			Folder.GameThreadCells.Add(Itr);
+			continue;
+		}
+
+		Folder.Cells++;
+		Folder.Bytes += FileSize;
+		if (!bDecoded)
+		{
+			Folder.Errors.Add(FString::Printf(TEXT("%s failed to decode."), *Itr));
+			continue;
+		}
+
+		for (const auto& Record : Data.SaveDatas)
+		{
+			AddRecordStats(Folder.Classes, Record.Value, Scratch);
+		}
+		for (const auto& Record : Data.Dense.SaveDatas)
+		{
+			AddRecordStats(Folder.Classes, Record, Scratch);
+		}
+		for (const auto& Record : Data.RuntimeActorsSaveDatas)
+		{
+			AddClassStats(Folder.Classes, Record.ActorClass.IsNull() ? TEXT("<None>") : Record.ActorClass.ToSoftObjectPath().GetAssetName(),
+				MeasureStruct(FStreamingLevelSaveRuntimeData::StaticStruct(), &Record, Scratch));
+		}
+
+		// Integrity.
+		const int32 Duplicates = Data.DestroyedActors.Num() - TSet<FGuid>(Data.DestroyedActors).Num();
+		if (InvalidRecords > 0)
+		{
+			Folder.Errors.Add(FString::Printf(TEXT("%s has %d records without guid, struct or class."), *Itr, InvalidRecords));
+		}
+
+		const auto& Dense = Data.Dense;
+		if (Dense.LayoutHash != 0 && (!Dense.IsValid() || Dense.DestroyedBits.Num() != FMath::DivideAndRoundUp(Dense.Guids.Num(), 32)))
+		{
+			Folder.Errors.Add(FString::Printf(TEXT("%s has an inconsistent dense layout."), *Itr));
+		}
+
+		if (bHasManifest && Manifest.StoredCells.Contains(Itr))
+		{
+			uint64 Hash = 0;
+			FStreamingLevelSaveCellDigest Digest;
+			const auto Expected = Manifest.CellDigests.Find(Itr);
+			if (!FStreamingLevelSaveSlot::DigestFile(FilePath, Hash, Digest) || Manifest.CellHashes.FindRef(Itr) != Hash
+				|| !Expected || *Expected != Digest)
+			{
+				Folder.Errors.Add(FString::Printf(TEXT("%s does not match manifest hash."), *Itr));
+			}
+		}
+
+		const bool bOutdated = Version != static_cast<int32>(EStreamingLevelSaveCellFileVersion::Latest)
+			|| Format != Settings->CellFileCompressionFormat;
+		if (bCompact && !Folder.bReadOnly && (Duplicates > 0 || bOutdated || HasUnknownGuids(Data, KnownGuids)))
+		{
+			Folder.RewriteCells.Add(Itr);
+		}
+
+		Folder.CellLines.Add(FString::Printf(TEXT("%s: %lld bytes, version %d, %s, %d persistent, %d dense, %d destroyed (%d duplicate), %d runtime"),
+			*Itr, FileSize, Version, *Format.ToString(), Data.SaveDatas.Num(), Dense.SaveDatas.Num(), Data.DestroyedActors.Num(), Duplicates,
+			Data.RuntimeActorsSaveDatas.Num()));
+	}
+
+	if (!bHasManifest || OnlyCells)
+	{
+		return;
+	}
+
+	for (const auto& Itr : Manifest.StoredCells)
+	{
+		if (!CellFiles.Contains(Itr))
+		{
+			Folder.Errors.Add(FString::Printf(TEXT("stored cell %s is missing."), *Itr));
+		}
+	}
+
+	if (Manifest.bContentAddressed)
+	{
+		for (const auto& Itr : Manifest.CellHashes)
+		{
+			// Cells with colliding hash are stored by slot.
+			if (Manifest.StoredCells.Contains(Itr.Key))
+			{
+				continue;
+			}
+
+			const FString StorePath = FStreamingLevelSaveSlot::MakeCellStorePath(Itr.Value);
+			uint64 Hash = 0;
+			FStreamingLevelSaveCellDigest Digest;
+			const auto Expected = Manifest.CellDigests.Find(Itr.Key);
+			if (!FileManager.FileExists(*StorePath))
+			{
+				Folder.Errors.Add(FString::Printf(TEXT("%s is missing from cell store."), *Itr.Key));
+			}
+			else if (!Expected || !FStreamingLevelSaveSlot::DigestFile(StorePath, Hash, Digest) || *Expected != Digest)
+			{
+				Folder.Errors.Add(FString::Printf(TEXT("%s in cell store does not match manifest digest."), *Itr.Key));
+			}
+		}
+	}
+	else if (Manifest.IsDifferential()
+		&& !FileManager.FileExists(*(FStreamingLevelSaveSlot::MakeLevelsFolder(Manifest.BaseSlot, Manifest.LevelsFolderName) / FStreamingLevelSaveSlotManifest::FileName)))
+	{
+		Folder.Errors.Add(FString::Printf(TEXT("base slot %s is missing."), *Manifest.BaseSlot));
+	}
+}
+
+static void CompactFolder(FStreamingLevelSaveInspectFolder& Folder, const TSet<FGuid>& KnownGuids)
+{
+	const int32 Num = Folder.RewriteCells.Num();
+	if (Num == 0)
+	{
+		return;
+	}
+
+	// Decode on game thread so referenced objects load and survive the rewrite.
+	IFileManager& FileManager = IFileManager::Get();
+	TArray<FStreamingLevelSaveData> Datas;
+	TArray<bool> Decoded;
+	Datas.SetNum(Num);
+	Decoded.SetNumZeroed(Num);
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const FString FilePath = Folder.Path / Folder.RewriteCells[Index];
+		Folder.RewrittenBytesBefore += FMath::Max<int64>(FileManager.FileSize(*FilePath), 0);
+		Decoded[Index] = FStreamingLevelSaveCellFile::Load(FilePath, Datas[Index]);
+	}
+
+	TArray<uint64> Hashes;
+	TArray<FStreamingLevelSaveCellDigest> Digests;
+	TArray<bool> Saved;
+	Hashes.SetNumZeroed(Num);
+	Digests.SetNum(Num);
+	Saved.SetNumZeroed(Num);
+	ParallelFor(Num, [&](int32 Index)
+	{
+		if (Decoded[Index])
+		{
+			const FString FilePath = Folder.Path / Folder.RewriteCells[Index];
+			CompactCell(Datas[Index], KnownGuids);
+			Saved[Index] = FStreamingLevelSaveCellFile::Save(FilePath, Datas[Index])
+				&& FStreamingLevelSaveSlot::DigestFile(FilePath, Hashes[Index], Digests[Index]);
+		}
+	});
+
+	FStreamingLevelSaveSlotManifest Manifest;
+	const bool bHasManifest = Manifest.Load(Folder.Path);
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const auto& CellFile = Folder.RewriteCells[Index];
+		if (!Saved[Index])
+		{
+			Folder.Errors.Add(FString::Printf(TEXT("%s failed to rewrite."), *CellFile));
+			continue;
+		}
+
+		Folder.RewrittenCells++;
+		Folder.RewrittenBytesAfter += FMath::Max<int64>(FileManager.FileSize(*(Folder.Path / CellFile)), 0);
+		if (bHasManifest && Manifest.CellHashes.Contains(CellFile))
+		{
+			Manifest.CellHashes.Add(CellFile, Hashes[Index]);
+			Manifest.CellDigests.Add(CellFile, Digests[Index]);
+		}
+	}
+
+	if (bHasManifest && !Manifest.Save(Folder.Path))
+	{
+		Folder.Errors.Add(TEXT("manifest failed to save."));
+	}
+}
+
+UStreamingLevelSaveInspectCommandlet::UStreamingLevelSaveInspectCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UStreamingLevelSaveInspectCommandlet::Main(const FString& Params)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const bool bCompact = FParse::Param(*Params, TEXT("Compact"));
+	const bool bPrintCells = FParse::Param(*Params, TEXT("Cells"));
+
+	TSet<FGuid> KnownGuids;
+	if (FString KnownGuidsFile; FParse::Value(*Params, TEXT("KnownGuids="), KnownGuidsFile))
+	{
+		TArray<FString> Lines;
+		FFileHelper::LoadFileToStringArray(Lines, *KnownGuidsFile);
+		for (const auto& Itr : Lines)
+		{
+			if (FGuid Id; FGuid::Parse(Itr.TrimStartAndEnd(), Id))
+			{
+				KnownGuids.Add(Id);
+			}
+		}
+
+		// An empty list would drop every persistent data.
+		if (KnownGuids.Num() == 0)
+		{
+			UE_LOG(LogStreamingLevelSaveInspect, Error, TEXT("No guids read from %s."), *KnownGuidsFile);
+			return 1;
+		}
+		UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("Read %d known guids from %s."), KnownGuids.Num(), *KnownGuidsFile);
+	}
+
+	TArray<FString> SlotNames;
+	FString SlotsParam;
+	const bool bAllSlots = !FParse::Value(*Params, TEXT("Slots="), SlotsParam);
+	if (bAllSlots)
+	{
+		const FString TempFolderName = UStreamingLevelSaveSettings::GetTempFileFolder();
+		FileManager.FindFiles(SlotNames, *(FPaths::ProjectSavedDir() + "SaveGames/*"), false, true);
+		SlotNames.RemoveAll([&TempFolderName](const FString& Itr)
+		{
+			return Itr.StartsWith(TEXT("_")) || Itr.StartsWith(TempFolderName) || IsStagingFolderName(Itr);
+		});
+	}
+	else
+	{
+		SlotsParam.ParseIntoArray(SlotNames, TEXT("+"));
+	}
+	SlotNames.Sort();
+
+	TArray<FStreamingLevelSaveInspectFolder> Folders;
+	for (const auto& SlotName : SlotNames)
+	{
+		const FString SlotDir = UStreamingLevelSaveLibrary::MakeSaveGameDir(SlotName);
+		TArray<FString> SubFolders;
+		FileManager.FindFiles(SubFolders, *(SlotDir + TEXT("*")), false, true);
+
+		TSet<FString> LevelsFolderNames;
+		for (const auto& Itr : SubFolders)
+		{
+			LevelsFolderNames.Add(IsStagingFolderName(Itr) ? Itr.Left(Itr.Find(TEXT("_"), ESearchCase::CaseSensitive, ESearchDir::FromEnd)) : Itr);
+		}
+
+		for (const auto& Itr : LevelsFolderNames)
+		{
+			const FString LevelsFolder = SlotDir + Itr;
+			if (bCompact)
+			{
+				FStreamingLevelSaveFileWriter::RecoverFolder(LevelsFolder);
+			}
+			if (FileManager.DirectoryExists(*LevelsFolder))
+			{
+				auto& Folder = Folders.AddDefaulted_GetRef();
+				Folder.Name = SlotName / Itr;
+				Folder.Path = LevelsFolder;
+			}
+		}
+	}
+
+	if (FParse::Param(*Params, TEXT("Temp")))
+	{
+		auto& Folder = Folders.AddDefaulted_GetRef();
+		Folder.Name = TEXT("Temp");
+		Folder.Path = UStreamingLevelSaveLibrary::GetTempFileFolder();
+	}
+
+	if (bAllSlots && FileManager.DirectoryExists(*FStreamingLevelSaveSlot::GetCellStoreDir()))
+	{
+		auto& Folder = Folders.AddDefaulted_GetRef();
+		Folder.Name = TEXT("CellStore");
+		Folder.Path = FStreamingLevelSaveSlot::GetCellStoreDir();
+		Folder.bReadOnly = true;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	ParallelFor(Folders.Num(), [&Folders, &KnownGuids, bCompact](int32 Index)
+	{
+		InspectFolder(Folders[Index], KnownGuids, bCompact);
+	});
+
+	// Loading their struct and class packages is only allowed here.
+	for (auto& Itr : Folders)
+	{
+		if (Itr.GameThreadCells.Num() > 0)
+		{
+			const TArray<FString> Cells = MoveTemp(Itr.GameThreadCells);
+			InspectFolder(Itr, KnownGuids, bCompact, &Cells);
+			Itr.CellLines.Sort();
+		}
+	}
+
+	if (bCompact)
+	{
+		for (auto& Itr : Folders)
+		{
+			CompactFolder(Itr, KnownGuids);
+		}
+	}
+
+	int32 Cells = 0;
+	int64 Bytes = 0;
+	int32 Errors = 0;
+	int32 RewrittenCells = 0;
+	int64 RewrittenBytesBefore = 0;
+	int64 RewrittenBytesAfter = 0;
+	TMap<FString, FStreamingLevelSaveClassStats> Classes;
+	for (const auto& Folder : Folders)
+	{
+		Cells += Folder.Cells;
+		Bytes += Folder.Bytes;
+		Errors += Folder.Errors.Num();
+		RewrittenCells += Folder.RewrittenCells;
+		RewrittenBytesBefore += Folder.RewrittenBytesBefore;
+		RewrittenBytesAfter += Folder.RewrittenBytesAfter;
+		for (const auto& Itr : Folder.Classes)
+		{
+			auto& Stats = Classes.FindOrAdd(Itr.Key);
+			Stats.Count += Itr.Value.Count;
+			Stats.Bytes += Itr.Value.Bytes;
+		}
+
+		if (bPrintCells)
+		{
+			UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("%s: %d cells, %lld bytes"), *Folder.Name, Folder.Cells, Folder.Bytes);
+			for (const auto& Itr : Folder.CellLines)
+			{
+				UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("  %s"), *Itr);
+			}
+		}
+		for (const auto& Itr : Folder.Errors)
+		{
+			UE_LOG(LogStreamingLevelSaveInspect, Error, TEXT("%s: %s"), *Folder.Name, *Itr);
+		}
+	}
+
+	Classes.ValueSort([](const FStreamingLevelSaveClassStats& A, const FStreamingLevelSaveClassStats& B) { return A.Bytes > B.Bytes; });
+	UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("%-48s %10s %14s"), TEXT("Class"), TEXT("Records"), TEXT("Bytes"));
+	for (const auto& Itr : Classes)
+	{
+		UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("%-48s %10d %14lld"), *Itr.Key, Itr.Value.Count, Itr.Value.Bytes);
+	}
+
+	UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("%d folders, %d cells, %lld bytes, %d errors in %.2fs."),
+		Folders.Num(), Cells, Bytes, Errors, FPlatformTime::Seconds() - StartTime);
+	if (bCompact)
+	{
+		UE_LOG(LogStreamingLevelSaveInspect, Display, TEXT("Rewrote %d cells, %lld bytes to %lld bytes."),
+			RewrittenCells, RewrittenBytesBefore, RewrittenBytesAfter);
+	}
+
+	return Errors > 0 ? 1 : 0;
+}
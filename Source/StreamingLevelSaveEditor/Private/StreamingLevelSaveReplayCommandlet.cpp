@@ -0,0 +1,277 @@
+﻿#include "StreamingLevelSaveReplayCommandlet.h"
+
+#include "StreamingLevelSaveCellFile.h"
+#include "StreamingLevelSaveLibrary.h"
+#include "StreamingLevelSaveRecorder.h"
+#include "StreamingLevelSaveSettings.h"
+#include "StreamingLevelSaveSubsystem.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Misc/FileHelper.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogStreamingLevelSaveReplay, Log, All);
+
+static FString MakeSyntheticCellName(int32 CellIndex)
+{
+	return FString::Printf(TEXT("SyntheticCell_%03d"), CellIndex);
+}
+
+static void MakeSyntheticSession(int32 NumCells, int32 NumEvents, FRandomStream& Random, TArray<FStreamingLevelSaveRecordedEvent>& OutEvents)
+{
+	// Random walk, up to a quarter of the cells loaded at a time.
+	TArray<int32> Loaded;
+	TArray<int32> Unloaded;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		Unloaded.Add(Index);
+	}
+
+	const int32 MaxLoaded = FMath::Max(1, NumCells / 4);
+	double Time = 0.0;
+	while (OutEvents.Num() < NumEvents)
+	{
+		Time += Random.FRandRange(0.01f, 0.1f);
+		const bool bAdd = Loaded.Num() == 0 || (Unloaded.Num() > 0 && Loaded.Num() < MaxLoaded && Random.RandHelper(2) == 0);
+		auto& From = bAdd ? Unloaded : Loaded;
+		auto& To = bAdd ? Loaded : Unloaded;
+		const int32 Picked = Random.RandHelper(From.Num());
+		const int32 CellIndex = From[Picked];
+		From.RemoveAtSwap(Picked);
+		To.Add(CellIndex);
+
+		auto& Event = OutEvents.AddDefaulted_GetRef();
+		Event.Time = Time;
+		Event.Name = MakeSyntheticCellName(CellIndex);
+		if (bAdd)
+		{
+			// Decode starts while level package loads, level is added a little later.
+			Event.Event = EStreamingLevelSaveRecordEvent::BeginDecode;
+			FStreamingLevelSaveRecordedEvent Added = Event;
+			Added.Time += 0.005;
+			Added.Event = EStreamingLevelSaveRecordEvent::LoadLevel;
+			OutEvents.Add(MoveTemp(Added));
+		}
+		else
+		{
+			Event.Event = EStreamingLevelSaveRecordEvent::SaveLevel;
+			Event.Flags = EStreamingLevelSaveRecordFlags::Async;
+		}
+	}
+}
+
+static FTransform MakeRandomTransform(FRandomStream& Random)
+{
+	return FTransform(FRotator(Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f), 0.f),
+		Random.GetUnitVector() * Random.FRandRange(0.f, 12800.f));
+}
+
+static void MakeSyntheticData(const FString& CellName, int32 NumRecords, FRandomStream& Random, FStreamingLevelSaveData& OutData)
+{
+	const FSoftObjectPath ActorClassPath(TEXT("/Game/Synthetic/BP_SyntheticItem.BP_SyntheticItem_C"));
+	for (int32 Index = 0; Index < NumRecords; ++Index)
+	{
+		const auto Id = FGuid::NewDeterministicGuid(CellName + FString::FromInt(Index));
+		if (Index % 8 == 0)
+		{
+			OutData.DestroyedActors.Add(Id);
+		}
+		else
+		{
+			const FTransform Transform = MakeRandomTransform(Random);
+			FInstancedStruct Record;
+			Record.InitializeAs(TBaseStructure<FTransform>::Get(), reinterpret_cast<const uint8*>(&Transform));
+			OutData.SaveDatas.Add(Id, MoveTemp(Record));
+		}
+
+		auto& RuntimeData = OutData.RuntimeActorsSaveDatas.AddDefaulted_GetRef();
+		RuntimeData.ActorClass = TSoftClassPtr<AActor>(ActorClassPath);
+		RuntimeData.ActorTransform = MakeRandomTransform(Random);
+		RuntimeData.ActorVelocity = Index % 4 == 0 ? Random.GetUnitVector() * 100.0 : FVector::ZeroVector;
+	}
+}
+
+static double GetPercentile(const TArray<double>& SortedValues, double Percentile)
+{
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(SortedValues.Num() * Percentile) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+UStreamingLevelSaveReplayCommandlet::UStreamingLevelSaveReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UStreamingLevelSaveReplayCommandlet::Main(const FString& Params)
+{
+	int32 NumCells = 64;
+	int32 NumEvents = 2000;
+	int32 NumRecords = 500;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Cells="), NumCells);
+	FParse::Value(*Params, TEXT("Events="), NumEvents);
+	FParse::Value(*Params, TEXT("Records="), NumRecords);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FRandomStream Random(Seed);
+
+	TArray<FStreamingLevelSaveRecordedEvent> Events;
+	if (FString SessionFile; FParse::Value(*Params, TEXT("Session="), SessionFile))
+	{
+		if (!FStreamingLevelSaveRecorder::LoadSession(SessionFile, Events))
+		{
+			UE_LOG(LogStreamingLevelSaveReplay, Error, TEXT("Failed to read session %s."), *SessionFile);
+			return 1;
+		}
+	}
+	else
+	{
+		MakeSyntheticSession(FMath::Max(NumCells, 1), NumEvents, Random, Events);
+	}
+
+	// Prepare saved datas up front, only replayed calls are timed.
+	FString DataFolder;
+	FParse::Value(*Params, TEXT("Data="), DataFolder);
+	TMap<FString, FStreamingLevelSaveData> Payloads;
+	for (const auto& Itr : Events)
+	{
+		if (Itr.Event != EStreamingLevelSaveRecordEvent::SaveLevel || Payloads.Contains(Itr.Name))
+		{
+			continue;
+		}
+
+		auto& Payload = Payloads.Add(Itr.Name);
+		const FString FilePath = DataFolder / Itr.Name + TEXT(".sav");
+		if (DataFolder.IsEmpty() || !FPaths::FileExists(FilePath) || !FStreamingLevelSaveCellFile::Load(FilePath, Payload))
+		{
+			Payload = FStreamingLevelSaveData();
+			MakeSyntheticData(Itr.Name, NumRecords, Random, Payload);
+		}
+	}
+
+	// Replay writes and clears temp files, keep them apart from temp files of game.
+	UStreamingLevelSaveSettings::SetTempFileFolderOverride(UStreamingLevelSaveSettings::GetTempFileFolder() + TEXT("_Replay"));
+	const auto GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->InitializeStandalone();
+	const auto Subsystem = GameInstance->GetSubsystem<UStreamingLevelSaveSubsystem>();
+	if (!Subsystem)
+	{
+		UE_LOG(LogStreamingLevelSaveReplay, Error, TEXT("Streaming level save subsystem is not created."));
+		GameInstance->Shutdown();
+		UStreamingLevelSaveSettings::SetTempFileFolderOverride(FString());
+		return 1;
+	}
+	Subsystem->ClearAllTempFiles();
+	UE_LOG(LogStreamingLevelSaveReplay, Display, TEXT("Replaying in %s."), *UStreamingLevelSaveLibrary::GetTempFileFolder());
+
+	// Engine does not tick in commandlets, run game thread tasks and subsystem tick between events.
+	double LastTickTime = FPlatformTime::Seconds();
+	auto TickSubsystem = [Subsystem, &LastTickTime]()
+	{
+		const double Now = FPlatformTime::Seconds();
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		static_cast<FTickableGameObject*>(Subsystem)->Tick(Now - LastTickTime);
+		LastTickTime = Now;
+	};
+
+	TMap<FString, TArray<double>> Timings;
+
+	// Same files read both ways, alternating so both see the same file cache.
+	if (int32 ReadRepeats = 0; FParse::Value(*Params, TEXT("ReadBench="), ReadRepeats) && ReadRepeats > 0)
+	{
+		for (auto& Pair : Payloads)
+		{
+			FStreamingLevelSaveCellFile::Save(UStreamingLevelSaveLibrary::MakeTempFilePath(Pair.Key), Pair.Value);
+		}
+
+		const auto Settings = GetMutableDefault<UStreamingLevelSaveSettings>();
+		const bool bWasMapped = Settings->bMemoryMapCellFiles;
+		for (int32 Repeat = 0; Repeat < ReadRepeats; ++Repeat)
+		{
+			for (const bool bMapped : { false, true })
+			{
+				Settings->bMemoryMapCellFiles = bMapped;
+				auto& ReadTimings = Timings.FindOrAdd(bMapped ? TEXT("ReadMapped") : TEXT("ReadBuffered"));
+				for (const auto& Pair : Payloads)
+				{
+					FStreamingLevelSaveData Data;
+					const double StartTime = FPlatformTime::Seconds();
+					FStreamingLevelSaveCellFile::Load(UStreamingLevelSaveLibrary::MakeTempFilePath(Pair.Key), Data);
+					ReadTimings.Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+				}
+			}
+		}
+		Settings->bMemoryMapCellFiles = bWasMapped;
+		Subsystem->ClearAllTempFiles();
+	}
+
+	const bool bRealtime = FParse::Param(*Params, TEXT("Realtime"));
+	const double ReplayStartTime = FPlatformTime::Seconds();
+	for (const auto& Itr : Events)
+	{
+		while (bRealtime && FPlatformTime::Seconds() - ReplayStartTime < Itr.Time)
+		{
+			TickSubsystem();
+			FPlatformProcess::Sleep(0.001f);
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		switch (Itr.Event)
+		{
+		case EStreamingLevelSaveRecordEvent::BeginDecode:
+			Subsystem->ReplayBeginDecode(Itr.Name);
+			break;
+		case EStreamingLevelSaveRecordEvent::SaveLevel:
+			Subsystem->ReplaySaveLevel(Itr.Name, Payloads[Itr.Name], EnumHasAnyFlags(Itr.Flags, EStreamingLevelSaveRecordFlags::OnlyCollect),
+				EnumHasAnyFlags(Itr.Flags, EStreamingLevelSaveRecordFlags::Async));
+			break;
+		case EStreamingLevelSaveRecordEvent::LoadLevel:
+			Subsystem->ReplayLoadLevel(Itr.Name);
+			break;
+		default:
+			// Level and sequence events only mark the timeline.
+			continue;
+		}
+		Timings.FindOrAdd(LexToString(Itr.Event)).Add((FPlatformTime::Seconds() - StartTime) * 1000.0);
+		TickSubsystem();
+	}
+
+	const double FlushStartTime = FPlatformTime::Seconds();
+	Subsystem->ReplayFlush();
+	Timings.FindOrAdd(TEXT("Flush")).Add((FPlatformTime::Seconds() - FlushStartTime) * 1000.0);
+	const double ReplaySeconds = FPlatformTime::Seconds() - ReplayStartTime;
+
+	TArray<FString> ReportLines;
+	ReportLines.Add(TEXT("Event,Count,TotalMs,AvgMs,P50Ms,P95Ms,MaxMs"));
+	Timings.KeySort(TLess<FString>());
+	for (auto& Itr : Timings)
+	{
+		Itr.Value.Sort();
+		double TotalMs = 0.0;
+		for (const auto Value : Itr.Value)
+		{
+			TotalMs += Value;
+		}
+
+		ReportLines.Add(FString::Printf(TEXT("%s,%d,%.3f,%.4f,%.4f,%.4f,%.4f"), *Itr.Key, Itr.Value.Num(), TotalMs, TotalMs / Itr.Value.Num(),
+			GetPercentile(Itr.Value, 0.5), GetPercentile(Itr.Value, 0.95), Itr.Value.Last()));
+	}
+
+	for (const auto& Itr : ReportLines)
+	{
+		UE_LOG(LogStreamingLevelSaveReplay, Display, TEXT("%s"), *Itr);
+	}
+	UE_LOG(LogStreamingLevelSaveReplay, Display, TEXT("Replayed %d events in %.3fs."), Events.Num(), ReplaySeconds);
+
+	if (FString ReportFile; FParse::Value(*Params, TEXT("Report="), ReportFile))
+	{
+		FFileHelper::SaveStringArrayToFile(ReportLines, *ReportFile);
+	}
+
+	Subsystem->ClearAllTempFiles();
+	GameInstance->Shutdown();
+	UStreamingLevelSaveSettings::SetTempFileFolderOverride(FString());
+	return 0;
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "StreamingLevelSaveInspectCommandlet.generated.h"
+
+/**
+ * Inspects save data offline: size statistics per cell and per class, integrity checks and optional compaction.
+ * Slot folders are processed in parallel.
+ *
+ * -run=StreamingLevelSaveInspect [-Slots=A+B] [-Temp] [-Cells] [-Compact] [-KnownGuids=File]
+ *   -Slots       Slots to process, every slot and the cell store if omitted.
+ *   -Temp        Also process temp cell files.
+ *   -Cells       Print statistics of every cell.
+ *   -Compact     Rewrite cells with current format and compression, deduplicate destroyed actors.
+ *   -KnownGuids  Text file with one identity guid per line, compaction drops persistent datas of other guids.
+ */
+UCLASS()
+class UStreamingLevelSaveInspectCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UStreamingLevelSaveInspectCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
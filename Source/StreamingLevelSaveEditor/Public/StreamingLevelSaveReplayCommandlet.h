@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "StreamingLevelSaveReplayCommandlet.generated.h"
+
+/**
+ * Replays a recorded or synthetic session against cell reads and writes of the subsystem, without playing the game.
+ * Times every replayed call so builds can be compared. Clears the project temp save folder.
+ *
+ * -run=StreamingLevelSaveReplay -nullrhi [-Session=File] [-Data=Folder] [-Realtime] [-ReadBench=N] [-Report=File]
+ *   -Session   Csv recorded with bRecordSessions, synthetic session if omitted.
+ *   -Data      Folder of cell files saved as captured data, by cell name. Missing cells get synthetic data.
+ *   -Cells=64 -Events=2000 -Records=500 -Seed=0  Shape of synthetic session and data.
+ *   -Realtime  Wait between events as recorded, else replay back to back.
+ *   -ReadBench Before replay, read and decode every saved cell N times buffered and N times memory mapped.
+ *   -Report    Write timings per event as csv.
+ */
+UCLASS()
+class UStreamingLevelSaveReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UStreamingLevelSaveReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};